@@ -59,6 +59,11 @@ public:
   QJsonObject
   save() const override;
 
+  /// Ids and port indexes of the nodes, followed by the converter types, if any.
+  /// Read by FlowScene::restoreConnection().
+  void
+  saveBinary(QDataStream & stream) const override;
+
 public:
 
   QUuid
@@ -1,9 +1,11 @@
 #pragma once
 
 #include <QtCore/QUuid>
+#include <QtCore/QDataStream>
 #include <QtWidgets/QGraphicsScene>
 
 #include <unordered_map>
+#include <unordered_set>
 #include <tuple>
 #include <functional>
 
@@ -54,12 +56,18 @@ public:
 
   std::shared_ptr<Connection>restoreConnection(QJsonObject const &connectionJson);
 
+  /// Read a connection written by Connection::saveBinary().
+  std::shared_ptr<Connection>restoreConnection(QDataStream &stream);
+
   void deleteConnection(Connection& connection);
 
   Node& createNode(std::unique_ptr<NodeDataModel> && dataModel );
 
   Node& restoreNode(QJsonObject const& nodeJson);
 
+  /// Read a node written by Node::saveBinary().
+  Node& restoreNode(QDataStream &stream);
+
   void removeNode(Node& node);
 
   DataModelRegistry&registry() const;
@@ -76,6 +84,17 @@ public:
 
   void setNodePosition(Node& node, const QPointF& pos) const;
 
+  /// Starts moving many nodes at once: until commitNodesMove(), setNodePosition()
+  /// moves only the nodes, and the item index of the scene is not used.
+  /// Calls can be nested. Nodes must be moved with setNodePosition(), not
+  /// setPos(), or their connections are not updated.
+  void beginNodesMove();
+
+  /// Updates once each connection of the nodes moved since beginNodesMove().
+  void commitNodesMove();
+
+  bool nodesMoveInProgress() const { return _nodesMoveDepth > 0; }
+
   QSizeF getNodeSize(const Node& node) const;
 public:
 
@@ -97,6 +116,18 @@ public:
 
   void loadFromMemory(const QByteArray& data);
 
+  /// Compact and faster alternative to saveToMemory(), meant for in-memory
+  /// snapshots. JSON remains the format of the files.
+  QByteArray saveToBinary() const;
+
+  /// Throws std::runtime_error if data was not created by saveToBinary().
+  void loadFromBinary(const QByteArray& data);
+
+  /// Header of the output of saveToBinary()
+  static const quint32 BinaryMagic = 0x514E5342;
+  static const quint16 BinaryVersion = 1;
+  static const int BinaryStreamVersion = QDataStream::Qt_5_0;
+
   void setLayout( QtNodes::PortLayout layout);
 
   QtNodes::PortLayout layout() const;
@@ -138,6 +169,28 @@ private:
 
   QtNodes::PortLayout _layout;
 
+  int _nodesMoveDepth;
+  ItemIndexMethod _nodesMoveIndexMethod;
+  mutable std::unordered_set<Node*> _movedNodes;
+
+};
+
+/// FlowScene::beginNodesMove() in the constructor, FlowScene::commitNodesMove()
+/// in the destructor.
+class ScopedNodesMove
+{
+public:
+  explicit ScopedNodesMove(FlowScene& scene)
+    : _scene(scene)
+  { _scene.beginNodesMove(); }
+
+  ~ScopedNodesMove() { _scene.commitNodesMove(); }
+
+  ScopedNodesMove(ScopedNodesMove const &) = delete;
+  ScopedNodesMove& operator=(ScopedNodesMove const &) = delete;
+
+private:
+  FlowScene& _scene;
 };
 
 Node*
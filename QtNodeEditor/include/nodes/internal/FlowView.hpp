@@ -27,6 +27,12 @@ public:
 
   void setScene(FlowScene *scene);
 
+  /// Shows or hides the details of all the nodes, according to the zoom.
+  /// Called by scaleUp() and scaleDown(); call it after setTransform().
+  void updateLevelOfDetail();
+
+  bool lowDetail() const { return _lowDetail; }
+
 public slots:
 
   void scaleUp();
@@ -72,5 +78,7 @@ private:
   QPointF _clickPos;
 
   FlowScene* _scene;
+
+  bool _lowDetail;
 };
 }
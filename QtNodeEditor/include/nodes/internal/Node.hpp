@@ -47,6 +47,14 @@ public:
   void
   restore(QJsonObject const &json) override;
 
+  /// Model name, id, model and position. The model name is read by
+  /// FlowScene::restoreNode(), before creating the node.
+  void
+  saveBinary(QDataStream & stream) const override;
+
+  void
+  restoreBinary(QDataStream & stream) override;
+
 public:
 
   QUuid
@@ -3,6 +3,7 @@
 #include <QtCore/QRectF>
 #include <QtCore/QPointF>
 #include <QtGui/QTransform>
+#include <QtGui/QFont>
 #include <QtGui/QFontMetrics>
 
 #include "PortType.hpp"
@@ -85,7 +86,8 @@ public:
   void
   recalculateSize() const;
 
-  /// Updates size if the QFontMetrics is changed
+  /// Updates size if the font is changed: cheap enough to be called
+  /// at every paint.
   void
   recalculateSize(QFont const &font) const;
 
@@ -123,6 +125,9 @@ public:
 
 private:
 
+  /// Metrics of a font, shared by all the nodes that use it.
+  class FontMetrics;
+
   unsigned int
   portWidth(PortType portType) const;
 
@@ -147,8 +152,8 @@ private:
 
   std::unique_ptr<NodeDataModel> const &_dataModel;
 
-  mutable QFontMetrics _fontMetrics;
-  mutable QFontMetrics _boldFontMetrics;
+  mutable QFont _font;
+  mutable FontMetrics const* _fontMetrics;
 
   PortLayout _ports_layout;
 };
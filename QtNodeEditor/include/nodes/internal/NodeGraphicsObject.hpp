@@ -57,6 +57,11 @@ public:
   void
   updateEmbeddedQWidget();
 
+  /// At a low level of detail the embedded widget and the drop shadow
+  /// are hidden. Set by FlowView when the zoom changes.
+  void
+  setLowDetail(bool lowDetail);
+
 protected:
   void
   paint(QPainter*                       painter,
@@ -102,6 +107,8 @@ private:
 
   // either nullptr or owned by parent QGraphicsItem
   QGraphicsProxyWidget * _proxyWidget;
+
+  bool _lowDetail;
   QPoint _press_pos;
 };
 }
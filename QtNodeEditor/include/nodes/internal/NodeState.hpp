@@ -1,7 +1,8 @@
 #pragma once
 
+#include <algorithm>
+#include <utility>
 #include <vector>
-#include <unordered_map>
 
 #include <QtCore/QUuid>
 
@@ -17,6 +18,102 @@ namespace QtNodes
 class Connection;
 class NodeDataModel;
 
+/// Connections of a port, in the order they were made.
+/// The nodes of a tree have one input connection and a few children: up to
+/// InlineCapacity connections are stored in place, without any allocation.
+class ConnectionPtrSet
+{
+public:
+  using value_type     = std::pair<QUuid, Connection*>;
+  using const_iterator = value_type const*;
+
+  enum { InlineCapacity = 4 };
+
+  ConnectionPtrSet()
+    : _inline()
+    , _size(0)
+  {}
+
+  std::size_t
+  size() const { return _size; }
+
+  bool
+  empty() const { return _size == 0; }
+
+  const_iterator
+  begin() const { return data(); }
+
+  const_iterator
+  end() const { return data() + _size; }
+
+  const_iterator
+  find(QUuid const& id) const
+  {
+    return std::find_if(begin(), end(),
+                        [&id](value_type const& v) { return v.first == id; });
+  }
+
+  /// Does nothing if a connection with the same id is already present.
+  bool
+  insert(value_type const& value)
+  {
+    if (find(value.first) != end())
+      return false;
+
+    if (!_heap.empty())
+    {
+      _heap.push_back(value);
+    }
+    else if (_size < InlineCapacity)
+    {
+      _inline[_size] = value;
+    }
+    else
+    {
+      _heap.reserve(InlineCapacity * 2);
+      _heap.assign(_inline, _inline + _size);
+      _heap.push_back(value);
+    }
+    ++_size;
+    return true;
+  }
+
+  std::size_t
+  erase(QUuid const& id)
+  {
+    auto it = find(id);
+    if (it == end())
+      return 0;
+
+    if (!_heap.empty())
+    {
+      _heap.erase(_heap.begin() + (it - begin()));
+    }
+    else
+    {
+      std::copy(it + 1, end(), _inline + (it - begin()));
+    }
+    --_size;
+    return 1;
+  }
+
+  void
+  clear()
+  {
+    _heap.clear();
+    _size = 0;
+  }
+
+private:
+
+  value_type const*
+  data() const { return _heap.empty() ? _inline : _heap.data(); }
+
+  value_type _inline[InlineCapacity];
+  std::vector<value_type> _heap; // all the connections, when there are more than InlineCapacity
+  std::size_t _size;
+};
+
 /// Contains vectors of connected input and output connections.
 /// Stores bool for reacting on hovering connections
 class NODE_EDITOR_PUBLIC NodeState
@@ -34,8 +131,7 @@ public:
 
 public:
 
-  using ConnectionPtrSet =
-          std::unordered_map<QUuid, Connection*>;
+  using ConnectionPtrSet = QtNodes::ConnectionPtrSet;
 
   /// Returns vector of connections ID.
   /// Some of them can be empty (null)
@@ -45,7 +141,8 @@ public:
   std::vector<ConnectionPtrSet> &
   getEntries(PortType);
 
-  ConnectionPtrSet
+  /// An empty set if portIndex is not valid.
+  ConnectionPtrSet const&
   connections(PortType portType, PortIndex portIndex) const;
 
   void
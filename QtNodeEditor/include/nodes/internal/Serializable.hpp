@@ -1,6 +1,8 @@
 #pragma once
 
 #include <QtCore/QJsonObject>
+#include <QtCore/QJsonDocument>
+#include <QtCore/QDataStream>
 
 namespace QtNodes
 {
@@ -18,5 +20,22 @@ public:
 
   virtual void
   restore(QJsonObject const & /*p*/) {}
+
+  /// Compact counterpart of save(), used for in-memory snapshots.
+  /// By default, the output of save() is stored.
+  virtual void
+  saveBinary(QDataStream & stream) const
+  {
+    stream << QJsonDocument(save()).toJson(QJsonDocument::Compact);
+  }
+
+  /// Read what saveBinary() wrote.
+  virtual void
+  restoreBinary(QDataStream & stream)
+  {
+    QByteArray json;
+    stream >> json;
+    restore(QJsonDocument::fromJson(json).object());
+  }
 };
 }
@@ -121,6 +121,27 @@ save() const
 }
 
 
+void
+Connection::
+saveBinary(QDataStream & stream) const
+{
+  if (!_inNode || !_outNode)
+  {
+    return;
+  }
+  stream << _outNode->id() << qint32(_outPortIndex)
+         << _inNode->id()  << qint32(_inPortIndex);
+
+  stream << bool(_converter);
+  if (_converter)
+  {
+    NodeDataType inType  = dataType(PortType::In);
+    NodeDataType outType = dataType(PortType::Out);
+    stream << inType.id << inType.name << outType.id << outType.name;
+  }
+}
+
+
 QUuid
 Connection::
 id() const
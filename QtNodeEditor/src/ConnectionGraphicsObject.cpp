@@ -13,6 +13,7 @@
 #include "ConnectionPainter.hpp"
 #include "ConnectionState.hpp"
 #include "ConnectionBlurEffect.hpp"
+#include "NodePainter.hpp"
 
 #include "NodeGraphicsObject.hpp"
 
@@ -143,6 +144,15 @@ paint(QPainter* painter,
 {
     painter->setClipRect(option->exposedRect);
 
+  double const lod =
+    option->levelOfDetailFromTransform(painter->worldTransform());
+
+  if (lod < NodePainter::LowDetailLevel)
+  {
+    ConnectionPainter::paintLowDetail(painter, _connection);
+    return;
+  }
+
   ConnectionPainter::paint(painter,
                            _connection);
 }
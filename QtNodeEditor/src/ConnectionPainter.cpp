@@ -307,3 +307,32 @@ paint(QPainter* painter,
   painter->drawEllipse(source, pointRadius, pointRadius);
   painter->drawEllipse(sink, pointRadius, pointRadius);
 }
+
+
+void
+ConnectionPainter::
+paintLowDetail(QPainter* painter,
+               Connection const &connection)
+{
+  // a connection being drawn by the user is never simplified
+  if (connection.connectionState().requiresPort())
+  {
+    paint(painter, connection);
+    return;
+  }
+
+  auto const & connectionStyle = connection.style();
+
+  bool const selected = connection.connectionGraphicsObject().isSelected();
+
+  QPen p(selected ? connectionStyle.selectedColor() :
+                    connectionStyle.normalColor());
+  p.setCosmetic(true);
+
+  painter->setRenderHint(QPainter::Antialiasing, false);
+  painter->setPen(p);
+
+  ConnectionGeometry const& geom = connection.connectionGeometry();
+
+  painter->drawLine(QLineF(geom.source(), geom.sink()));
+}
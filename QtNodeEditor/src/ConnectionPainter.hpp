@@ -18,6 +18,12 @@ public:
   paint(QPainter* painter,
         Connection const& connection);
 
+  /// A straight line between the end points, see NodePainter::LowDetailLevel.
+  static
+  void
+  paintLowDetail(QPainter* painter,
+                 Connection const& connection);
+
   static
   QPainterPath
   getPainterStroke(ConnectionGeometry const& geom);
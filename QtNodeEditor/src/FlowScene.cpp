@@ -37,12 +37,18 @@ using QtNodes::PortType;
 using QtNodes::PortIndex;
 using QtNodes::TypeConverter;
 
+const quint32 FlowScene::BinaryMagic;
+const quint16 FlowScene::BinaryVersion;
+const int FlowScene::BinaryStreamVersion;
+
 
 FlowScene::
 FlowScene(std::shared_ptr<DataModelRegistry> registry,
           QObject * parent)
   : QGraphicsScene(parent)
   , _registry(std::move(registry))
+  , _nodesMoveDepth(0)
+  , _nodesMoveIndexMethod(QGraphicsScene::NoIndex)
 {
   setItemIndexMethod(QGraphicsScene::NoIndex);
 }
@@ -189,6 +195,47 @@ restoreConnection(QJsonObject const &connectionJson)
 }
 
 
+std::shared_ptr<Connection>
+FlowScene::
+restoreConnection(QDataStream &stream)
+{
+  QUuid nodeOutId, nodeInId;
+  qint32 portIndexOut, portIndexIn;
+  bool hasConverter;
+  stream >> nodeOutId >> portIndexOut >> nodeInId >> portIndexIn >> hasConverter;
+
+  TypeConverter converter;
+  if (hasConverter)
+  {
+    NodeDataType inType, outType;
+    stream >> inType.id >> inType.name >> outType.id >> outType.name;
+    converter = registry().getTypeConverter(outType, inType);
+  }
+
+  auto inIt  = _nodes.find(nodeInId);
+  auto outIt = _nodes.find(nodeOutId);
+
+  if( inIt == _nodes.end() || outIt == _nodes.end() ||
+      !inIt->second || !outIt->second )
+  {
+      qDebug() << "ERROR: invalid connection with UIDS "
+               << nodeInId << " and " << nodeOutId;
+
+      return std::shared_ptr<Connection>();
+  }
+
+  std::shared_ptr<Connection> connection =
+    createConnection(*inIt->second, portIndexIn,
+                     *outIt->second, portIndexOut,
+                     converter);
+
+  connectionCreated(*connection);
+
+  connection->connectionGeometry().setPortLayout( layout() );
+  return connection;
+}
+
+
 void
 FlowScene::
 deleteConnection(Connection& connection)
@@ -251,6 +298,40 @@ restoreNode(QJsonObject const& nodeJson)
 }
 
 
+Node&
+FlowScene::
+restoreNode(QDataStream &stream)
+{
+  QString modelName;
+  stream >> modelName;
+
+  auto dataModel = registry().create(modelName);
+
+  if (!dataModel)
+  {
+    throw std::logic_error(std::string("No registered model with name ") +
+                           modelName.toLocal8Bit().data());
+  }
+
+  auto node = detail::make_unique<Node>(std::move(dataModel));
+  auto ngo  = detail::make_unique<NodeGraphicsObject>(*this, *node);
+  node->setGraphicsObject(std::move(ngo));
+
+  node->restoreBinary(stream);
+
+  node->nodeState().getEntries(PortType::In).resize( node->nodeDataModel()->nPorts(PortType::In));
+  node->nodeState().getEntries(PortType::Out).resize( node->nodeDataModel()->nPorts(PortType::Out));
+
+  auto nodePtr = node.get();
+  nodePtr->nodeGeometry().setPortLayout( layout() );
+  auto id = node->id();
+  _nodes[ id ] = std::move(node);
+
+  nodeCreated(*nodePtr);
+  return *nodePtr;
+}
+
+
 void
 FlowScene::
 removeNode(Node& node)
@@ -260,8 +341,8 @@ removeNode(Node& node)
 
   for(auto portType: {PortType::In,PortType::Out})
   {
-    auto nodeState = node.nodeState();
-    auto const & nodeEntries = nodeState.getEntries(portType);
+    // a copy: deleteConnection() erases the connections from the NodeState
+    auto const nodeEntries = node.nodeState().getEntries(portType);
 
     for (auto &connections : nodeEntries)
     {
@@ -270,6 +351,7 @@ removeNode(Node& node)
     }
   }
 
+  _movedNodes.erase(&node);
   _nodes.erase(node.id());
 }
 
@@ -324,7 +406,7 @@ iterateOverNodeDataDependentOrder(std::function<void(NodeDataModel*)> const & vi
     {
       for (unsigned int i = 0; i < model.nPorts(PortType::In); ++i)
       {
-        auto connections = node.nodeState().connections(PortType::In, i);
+        auto const &connections = node.nodeState().connections(PortType::In, i);
         if (!connections.empty())
         {
           return false;
@@ -352,7 +434,7 @@ iterateOverNodeDataDependentOrder(std::function<void(NodeDataModel*)> const & vi
     {
       for (size_t i = 0; i < model.nPorts(PortType::In); ++i)
       {
-        auto connections = node.nodeState().connections(PortType::In, i);
+        auto const &connections = node.nodeState().connections(PortType::In, i);
 
         for (auto& conn : connections)
         {
@@ -400,7 +482,52 @@ FlowScene::
 setNodePosition(Node& node, const QPointF& pos) const
 {
   node.nodeGraphicsObject().setPos(pos);
-  node.nodeGraphicsObject().moveConnections();
+
+  if (_nodesMoveDepth > 0)
+    _movedNodes.insert(&node);
+  else
+    node.nodeGraphicsObject().moveConnections();
+}
+
+
+void
+FlowScene::
+beginNodesMove()
+{
+  if (_nodesMoveDepth++ == 0)
+  {
+    _nodesMoveIndexMethod = itemIndexMethod();
+    setItemIndexMethod(QGraphicsScene::NoIndex);
+  }
+}
+
+
+void
+FlowScene::
+commitNodesMove()
+{
+  if (_nodesMoveDepth == 0 || --_nodesMoveDepth > 0)
+    return;
+
+  // a connection between two moved nodes is updated only once
+  std::unordered_set<Connection*> connections;
+  for (Node* node : _movedNodes)
+  {
+    for (auto portType : {PortType::In, PortType::Out})
+    {
+      for (auto const & entries : node->nodeState().getEntries(portType))
+      {
+        for (auto const & pair : entries)
+          connections.insert(pair.second);
+      }
+    }
+  }
+  _movedNodes.clear();
+
+  for (Connection* connection : connections)
+    connection->connectionGraphicsObject().move();
+
+  setItemIndexMethod(_nodesMoveIndexMethod);
 }
 
 
@@ -593,6 +720,87 @@ loadFromMemory(const QByteArray& data)
 }
 
 
+QByteArray
+FlowScene::
+saveToBinary() const
+{
+  QByteArray data;
+  QDataStream stream(&data, QIODevice::WriteOnly);
+  stream.setVersion(BinaryStreamVersion);
+
+  stream << BinaryMagic << BinaryVersion;
+  stream << quint8(layout() == PortLayout::Horizontal ? 0 : 1);
+
+  quint32 nodesCount = 0;
+  for (auto const & pair : _nodes)
+  {
+    if (pair.second)
+      nodesCount++;
+  }
+  stream << nodesCount;
+  for (auto const & pair : _nodes)
+  {
+    if (pair.second)
+      pair.second->saveBinary(stream);
+  }
+
+  quint32 connectionsCount = 0;
+  for (auto const & pair : _connections)
+  {
+    if (pair.second && pair.second->getNode(PortType::In) && pair.second->getNode(PortType::Out))
+      connectionsCount++;
+  }
+  stream << connectionsCount;
+  for (auto const & pair : _connections)
+  {
+    if (pair.second && pair.second->getNode(PortType::In) && pair.second->getNode(PortType::Out))
+      pair.second->saveBinary(stream);
+  }
+
+  return data;
+}
+
+
+void
+FlowScene::
+loadFromBinary(const QByteArray& data)
+{
+  QDataStream stream(data);
+  stream.setVersion(BinaryStreamVersion);
+
+  quint32 magic;
+  quint16 version;
+  stream >> magic >> version;
+  if (stream.status() != QDataStream::Ok || magic != BinaryMagic || version != BinaryVersion)
+  {
+    throw std::runtime_error("Unknown format of the scene snapshot");
+  }
+
+  quint8 layout;
+  stream >> layout;
+  setLayout( (layout == 0) ? PortLayout::Horizontal : PortLayout::Vertical );
+
+  quint32 nodesCount;
+  stream >> nodesCount;
+  for (quint32 i = 0; i < nodesCount && stream.status() == QDataStream::Ok; i++)
+  {
+    restoreNode(stream);
+  }
+
+  quint32 connectionsCount;
+  stream >> connectionsCount;
+  for (quint32 i = 0; i < connectionsCount && stream.status() == QDataStream::Ok; i++)
+  {
+    restoreConnection(stream);
+  }
+
+  if (stream.status() != QDataStream::Ok)
+  {
+    throw std::runtime_error("Corrupted scene snapshot");
+  }
+}
+
+
 void FlowScene::setLayout( QtNodes::PortLayout layout)
 {
   _layout = layout;
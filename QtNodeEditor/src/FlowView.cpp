@@ -20,10 +20,13 @@
 #include "Node.hpp"
 #include "NodeGraphicsObject.hpp"
 #include "ConnectionGraphicsObject.hpp"
+#include "NodePainter.hpp"
 #include "StyleCollection.hpp"
 
 using QtNodes::FlowView;
 using QtNodes::FlowScene;
+using QtNodes::Node;
+using QtNodes::NodePainter;
 
 FlowView::
 FlowView(QWidget *parent)
@@ -31,6 +34,7 @@ FlowView(QWidget *parent)
   , _clearSelectionAction(Q_NULLPTR)
   , _deleteSelectionAction(Q_NULLPTR)
   , _scene(Q_NULLPTR)
+  , _lowDetail(false)
 {
   setDragMode(QGraphicsView::ScrollHandDrag);
   setRenderHint(QPainter::Antialiasing);
@@ -80,9 +84,21 @@ deleteSelectionAction() const
 void
 FlowView::setScene(FlowScene *scene)
 {
+  if (_scene)
+    disconnect(_scene, &FlowScene::nodeCreated, this, nullptr);
+
   _scene = scene;
   QGraphicsView::setScene(_scene);
 
+  if (_scene)
+  {
+    connect(_scene, &FlowScene::nodeCreated, this, [this](Node& node)
+    {
+      node.nodeGraphicsObject().setLowDetail(_lowDetail);
+    });
+  }
+  updateLevelOfDetail();
+
   // setup actions
   delete _clearSelectionAction;
   _clearSelectionAction = new QAction(QStringLiteral("Clear Selection"), this);
@@ -233,6 +249,7 @@ scaleUp()
     return;
 
   scale(factor, factor);
+  updateLevelOfDetail();
 }
 
 
@@ -244,6 +261,26 @@ scaleDown()
   double const factor = std::pow(step, -1.0);
 
   scale(factor, factor);
+  updateLevelOfDetail();
+}
+
+
+void
+FlowView::
+updateLevelOfDetail()
+{
+  double const lod =
+    QStyleOptionGraphicsItem::levelOfDetailFromTransform(transform());
+
+  _lowDetail = lod < NodePainter::LowDetailLevel;
+
+  if (!_scene)
+    return;
+
+  // also when the level did not change: a data model may have
+  // replaced the drop shadow of its node in the meantime
+  for (auto const & it : _scene->nodes())
+    it.second->nodeGraphicsObject().setLowDetail(_lowDetail);
 }
 
 
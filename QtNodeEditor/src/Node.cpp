@@ -83,6 +83,31 @@ restore(QJsonObject const& json)
 }
 
 
+void
+Node::
+saveBinary(QDataStream & stream) const
+{
+  stream << _nodeDataModel->name();
+  stream << _uid;
+  _nodeDataModel->saveBinary(stream);
+  // last, so that snapshots that differ only by position are easy to detect
+  stream << _nodeGraphicsObject->pos();
+}
+
+
+void
+Node::
+restoreBinary(QDataStream & stream)
+{
+  stream >> _uid;
+  _nodeDataModel->restoreBinary(stream);
+
+  QPointF point;
+  stream >> point;
+  _nodeGraphicsObject->setPos(point);
+}
+
+
 QUuid
 Node::
 id() const
@@ -207,7 +232,7 @@ onDataUpdated(PortIndex index)
 {
   auto nodeData = _nodeDataModel->outData(index);
 
-  auto connections =
+  auto const &connections =
     _nodeState.connections(PortType::Out, index);
 
   for (auto const & c : connections)
@@ -2,6 +2,7 @@
 
 #include <iostream>
 #include <cmath>
+#include <unordered_map>
 #include <QDebug>
 
 #include "PortType.hpp"
@@ -11,6 +12,7 @@
 #include "NodeGraphicsObject.hpp"
 
 #include "StyleCollection.hpp"
+#include "QStringStdHash.hpp"
 
 using QtNodes::NodeGeometry;
 using QtNodes::NodeDataModel;
@@ -19,6 +21,55 @@ using QtNodes::PortType;
 using QtNodes::PortLayout;
 using QtNodes::Node;
 
+class NodeGeometry::FontMetrics
+{
+public:
+
+  explicit
+  FontMetrics(QFont const &font)
+    : metrics(font)
+    , boldMetrics(boldFont(font))
+  {}
+
+  /// The same instance for all the fonts with the same QFont::key().
+  static FontMetrics const &
+  get(QFont const &font)
+  {
+    // never destroyed: QFontMetrics can not outlive the QGuiApplication
+    static auto cache = new std::unordered_map<QString, std::unique_ptr<FontMetrics>>();
+
+    auto &entry = (*cache)[font.key()];
+    if (!entry)
+      entry = QtNodes::detail::make_unique<FontMetrics>(font);
+    return *entry;
+  }
+
+  /// QFontMetrics::horizontalAdvance(), measured once for each text
+  int
+  horizontalAdvance(QString const &text) const
+  {
+    auto it = _advances.find(text);
+    if (it == _advances.end())
+      it = _advances.emplace(text, metrics.horizontalAdvance(text)).first;
+    return it->second;
+  }
+
+  QFontMetrics const metrics;
+  QFontMetrics const boldMetrics;
+
+private:
+
+  static QFont
+  boldFont(QFont font)
+  {
+    font.setPointSize(12);
+    return font;
+  }
+
+  mutable std::unordered_map<QString, int> _advances;
+};
+
+
 NodeGeometry::
 NodeGeometry(std::unique_ptr<NodeDataModel> const &dataModel)
   : _width(50)
@@ -30,14 +81,10 @@ NodeGeometry(std::unique_ptr<NodeDataModel> const &dataModel)
   , _hovered(false)
   , _draggingPos(-1000, -1000)
   , _dataModel(dataModel)
-  , _fontMetrics(QFont())
-  , _boldFontMetrics(QFont())
+  , _font()
+  , _fontMetrics(&FontMetrics::get(_font))
   , _ports_layout(PortLayout::Vertical  )
-{
-  QFont f;
-  f.setPointSize(12);
-  _boldFontMetrics = QFontMetrics(f);
-}
+{}
 
 unsigned int
 NodeGeometry::nSources() const
@@ -83,7 +130,7 @@ void
 NodeGeometry::
 recalculateSize() const
 {
-  _entryHeight = _fontMetrics.height();
+  _entryHeight = _fontMetrics->metrics.height();
 
   {
     unsigned int maxNumOfEntries = std::max(nSinks(), nSources());
@@ -120,16 +167,10 @@ void
 NodeGeometry::
 recalculateSize(QFont const & font) const
 {
-  QFontMetrics fontMetrics(font);
-  QFont boldFont = font;
-  boldFont.setPointSize(12);
-
-  QFontMetrics boldFontMetrics(boldFont);
-
-  if (_boldFontMetrics != boldFontMetrics)
+  if (font != _font)
   {
-    _fontMetrics     = fontMetrics;
-    _boldFontMetrics = boldFontMetrics;
+    _font        = font;
+    _fontMetrics = &FontMetrics::get(font);
     recalculateSize();
   }
 }
@@ -238,7 +279,7 @@ NodeGeometry::
 validationHeight() const
 {
   QString msg = _dataModel->validationMessage();
-  return _boldFontMetrics.boundingRect(msg).height();
+  return _fontMetrics->boldMetrics.boundingRect(msg).height();
 }
 
 
@@ -247,7 +288,7 @@ NodeGeometry::
 validationWidth() const
 {
   QString msg = _dataModel->validationMessage();
-  return _boldFontMetrics.boundingRect(msg).width();
+  return _fontMetrics->boldMetrics.boundingRect(msg).width();
 }
 
 
@@ -283,7 +324,7 @@ portWidth(PortType portType) const
   for (auto i = 0ul; i < _dataModel->nPorts(portType); ++i)
   {
     QString name = _dataModel->dataType(portType, i).name;
-    width = std::max(unsigned(_fontMetrics.horizontalAdvance(name)), width);
+    width = std::max(unsigned(_fontMetrics->horizontalAdvance(name)), width);
   }
 
   return width;
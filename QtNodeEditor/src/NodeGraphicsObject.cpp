@@ -30,6 +30,7 @@ NodeGraphicsObject(FlowScene &scene,
   , _locked(false)
   , _double_clicked(false)
   , _proxyWidget(nullptr)
+  , _lowDetail(false)
 {
   _scene.addItem(this);
 
@@ -116,6 +117,7 @@ updateEmbeddedQWidget()
 
     _proxyWidget->setOpacity(1.0);
     _proxyWidget->setFlag(QGraphicsItem::ItemIgnoresParentOpacity);
+    _proxyWidget->setVisible(!_lowDetail);
   }
 }
 
@@ -172,15 +174,48 @@ paint(QPainter * painter,
 {
   painter->setClipRect(option->exposedRect);
 
+  double const lod =
+    option->levelOfDetailFromTransform(painter->worldTransform());
+
+  if (lod < NodePainter::LowDetailLevel)
+  {
+    NodePainter::paintLowDetail(painter, _node);
+    return;
+  }
+
   NodePainter::paint(painter, _node, _scene);
 }
 
 
+void
+NodeGraphicsObject::
+setLowDetail(bool lowDetail)
+{
+  // the drop shadow may be replaced by the data model at any time
+  if (auto effect = graphicsEffect())
+  {
+    if (effect->isEnabled() == lowDetail)
+      effect->setEnabled(!lowDetail);
+  }
+
+  if (lowDetail == _lowDetail)
+    return;
+
+  _lowDetail = lowDetail;
+
+  // the embedded widget is the most expensive part of the node
+  // and can not be read anyway
+  if (_proxyWidget)
+    _proxyWidget->setVisible(!lowDetail);
+}
+
+
 QVariant
 NodeGraphicsObject::
 itemChange(GraphicsItemChange change, const QVariant &value)
 {
-  if (change == ItemPositionChange && scene())
+  // inside FlowScene::beginNodesMove(), the connections are updated at commit
+  if (change == ItemPositionChange && scene() && !_scene.nodesMoveInProgress())
   {
     moveConnections();
   }
@@ -221,7 +256,7 @@ mousePressEvent(QGraphicsSceneMouseEvent * event)
     {
       NodeState const & nodeState = _node.nodeState();
 
-      std::unordered_map<QUuid, Connection*> connections =
+      auto const &connections =
           nodeState.connections(portToCheck, portIndex);
 
       // start dragging existing connection
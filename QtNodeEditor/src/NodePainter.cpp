@@ -59,6 +59,34 @@ paint(QPainter* painter,
 }
 
 
+void
+NodePainter::
+paintLowDetail(QPainter* painter,
+               Node & node)
+{
+  NodeGeometry const& geom = node.nodeGeometry();
+
+  geom.recalculateSize(painter->font());
+
+  NodeStyle const& nodeStyle = node.nodeDataModel()->nodeStyle();
+
+  auto color = node.nodeGraphicsObject().isSelected()
+               ? nodeStyle.SelectedBoundaryColor
+               : nodeStyle.NormalBoundaryColor;
+
+  // the width of the border does not depend on the zoom,
+  // otherwise the status of the node would not be visible
+  QPen p(color, 2.0);
+  p.setCosmetic(true);
+
+  painter->setRenderHint(QPainter::Antialiasing, false);
+  painter->setPen(p);
+  painter->setBrush(nodeStyle.GradientColor1);
+
+  painter->drawRect(QRectF(0.0, 0.0, geom.width(), geom.height()));
+}
+
+
 void
 NodePainter::
 drawNodeRect(QPainter* painter,
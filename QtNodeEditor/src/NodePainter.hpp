@@ -21,12 +21,23 @@ public:
 
 public:
 
+  /// Below this level of detail (QStyleOptionGraphicsItem::levelOfDetailFromTransform)
+  /// nodes and connections are drawn with paintLowDetail().
+  static constexpr double LowDetailLevel = 0.4;
+
   static
   void
   paint(QPainter* painter,
         Node& node,
         FlowScene const& scene);
 
+  /// Only the box of the node, filled and with the color of its border:
+  /// used when the labels would be too small to be read.
+  static
+  void
+  paintLowDetail(QPainter* painter,
+                 Node& node);
+
   static
   void
   drawNodeRect(QPainter* painter,
@@ -43,14 +43,16 @@ getEntries(PortType portType)
 }
 
 
-NodeState::ConnectionPtrSet
+NodeState::ConnectionPtrSet const&
 NodeState::
 connections(PortType portType, PortIndex portIndex) const
 {
+  static const ConnectionPtrSet empty_set;
+
   auto const &connections = getEntries(portType);
   if( portIndex < 0 || static_cast<unsigned long>(portIndex) >= connections.size() )
   {
-    return NodeState::ConnectionPtrSet();
+    return empty_set;
   }
   return connections[portIndex];
 }
@@ -7,6 +7,11 @@
 #include <QMessageBox>
 #include <QtDebug>
 #include <QLineEdit>
+#include <QXmlStreamReader>
+#include <QXmlStreamWriter>
+#include <QMap>
+#include <QtConcurrent/QtConcurrentMap>
+#include <cstring>
 #include <unordered_map>
 
 using namespace QtNodes;
@@ -134,26 +139,42 @@ NodeModels ReadTreeNodesModel(const QDomElement &root)
 
 
 
-void RecursivelyCreateXml(const FlowScene &scene, QDomDocument &doc, QDomElement& parent_element, const Node *node)
-{
-
-    const QtNodes::NodeDataModel* node_model = node->nodeDataModel();
-    const std::string model_name = node_model->name().toStdString();
-
-    const auto* bt_node = dynamic_cast<const BehaviorTreeDataModel*>(node_model);
+namespace {
 
-    QString registration_name = bt_node->registrationName();
-    QDomElement element;
+// Attributes are written sorted by name, to make the output canonical.
+// As in QDomElement::setAttribute(), a later value replaces the previous one.
+typedef QMap<QString, QString> SortedAttributes;
 
+// Tag of the element; the model ID is added to the attributes, when needed.
+QString ElementTag(const QString& registration_name, NodeType type,
+                   SortedAttributes& attributes)
+{
     if( BuiltinNodeModels().count(registration_name) != 0)
     {
-        element = doc.createElement( registration_name.toStdString().c_str() );
+        return registration_name;
     }
-    else{
-        element = doc.createElement( QString::fromStdString(toStr(bt_node->nodeType())) );
-        element.setAttribute("ID", registration_name.toStdString().c_str() );
+    attributes.insert( "ID", registration_name );
+    return QString::fromStdString( toStr(type) );
+}
+
+void WriteStartElement(QXmlStreamWriter& stream, const QString& tag,
+                       const SortedAttributes& attributes)
+{
+    stream.writeStartElement( tag );
+    for(auto it = attributes.constBegin(); it != attributes.constEnd(); ++it)
+    {
+        stream.writeAttribute( it.key(), it.value() );
     }
+}
+
+}
+
+void RecursivelyCreateXml(QXmlStreamWriter& stream, const FlowScene &scene, const Node *node)
+{
+    const QtNodes::NodeDataModel* node_model = node->nodeDataModel();
+    const auto* bt_node = dynamic_cast<const BehaviorTreeDataModel*>(node_model);
 
+    const QString registration_name = bt_node->registrationName();
 
     bool is_subtree_expanded = false;
     if( auto subtree = dynamic_cast<const SubtreeNodeModel*>(node_model)  )
@@ -161,27 +182,69 @@ void RecursivelyCreateXml(const FlowScene &scene, QDomDocument &doc, QDomElement
         is_subtree_expanded = subtree->expanded();
     }
 
+    SortedAttributes attributes;
+    const QString tag = ElementTag( registration_name, bt_node->nodeType(), attributes );
+
     if( bt_node->instanceName() != registration_name )
     {
-        element.setAttribute("name", bt_node->instanceName().toStdString().c_str() );
+        attributes.insert( "name", bt_node->instanceName() );
     }
 
-    auto port_mapping = bt_node->getCurrentPortMapping();
+    const auto port_mapping = bt_node->getCurrentPortMapping();
     for(const auto& port_it: port_mapping)
     {
-        element.setAttribute( port_it.first, port_it.second );
+        attributes.insert( port_it.first, port_it.second );
     }
 
-    parent_element.appendChild( element );
+    WriteStartElement( stream, tag, attributes );
 
     if( !is_subtree_expanded )
     {
         auto node_children = getChildren(scene, *node, true );
         for(const QtNodes::Node* child : node_children)
         {
-            RecursivelyCreateXml(scene, doc, element, child );
+            RecursivelyCreateXml(stream, scene, child );
+        }
+    }
+    stream.writeEndElement();
+}
+
+void RecursivelyCreateXml(QXmlStreamWriter& stream, const AbsBehaviorTree &tree,
+                          const AbstractTreeNode *node)
+{
+    const QString& registration_name = node->model.registration_ID;
+
+    // see recursiveLoadStep(): a SubTree with a child is expanded
+    const bool is_subtree_expanded = ( node->model.type == NodeType::SUBTREE &&
+                                       node->children_index.size() == 1 );
+
+    SortedAttributes attributes;
+    const QString tag = ElementTag( registration_name, node->model.type, attributes );
+
+    if( node->instance_name != registration_name )
+    {
+        attributes.insert( "name", node->instance_name );
+    }
+
+    // BehaviorTreeDataModel has a field for each port of the model,
+    // initialized with the default value.
+    for(const auto& port_it: node->model.ports)
+    {
+        auto mapping_it = node->ports_mapping.find( port_it.first );
+        attributes.insert( port_it.first, (mapping_it != node->ports_mapping.end()) ?
+                               mapping_it->second : port_it.second.default_value );
+    }
+
+    WriteStartElement( stream, tag, attributes );
+
+    if( !is_subtree_expanded )
+    {
+        for(int child_index: node->children_index)
+        {
+            RecursivelyCreateXml(stream, tree, tree.node(child_index) );
         }
     }
+    stream.writeEndElement();
 }
 
 bool VerifyXML(QDomDocument &doc,
@@ -243,3 +306,527 @@ QDomElement writePortModel(const QString& port_name, const PortModel& port, QDom
   }
   return port_element;
 }
+
+void writePortModel(QXmlStreamWriter& stream, const QString& port_name, const PortModel& port)
+{
+  switch (port.direction)
+  {
+    case PortDirection::INPUT:
+      stream.writeStartElement("input_port");
+      break;
+    case PortDirection::OUTPUT:
+      stream.writeStartElement("output_port");
+      break;
+    case PortDirection::INOUT:
+      stream.writeStartElement("inout_port");
+      break;
+  }
+
+  // sorted by name, as in RecursivelyCreateXml()
+  if (port.default_value.isEmpty() == false)
+  {
+    stream.writeAttribute("default", port.default_value);
+  }
+  stream.writeAttribute("name", port_name);
+  if (port.type_name.isEmpty() == false)
+  {
+    stream.writeAttribute("type", port.type_name);
+  }
+
+  if (!port.description.isEmpty())
+  {
+    stream.writeCharacters(port.description);
+  }
+  stream.writeEndElement();
+}
+
+//------------------------------------------------------------------
+
+namespace {
+
+// Ports declared as attributes, as in buildTreeNodeModelFromXML()
+void ReadAttributePorts(const QXmlStreamAttributes& attributes, PortModels& ports_list)
+{
+    for(const auto& attr: attributes)
+    {
+        if( attr.name() != QLatin1String("ID") && attr.name() != QLatin1String("name") )
+        {
+            PortModel port_model;
+            port_model.direction = PortDirection::INOUT;
+            ports_list.insert( { attr.name().toString(), std::move(port_model)} );
+        }
+    }
+}
+
+// Same result of buildTreeNodeModelFromXML(). The current element is consumed.
+NodeModel ReadNodeModel(QXmlStreamReader& xml)
+{
+    const QString tag_name = xml.name().toString();
+    const auto node_type = BT::convertFromString<BT::NodeType>(tag_name.toStdString());
+
+    if( node_type == BT::NodeType::UNDEFINED )
+    {
+        xml.skipCurrentElement();
+        return {};
+    }
+
+    const QXmlStreamAttributes attributes = xml.attributes();
+    QString ID = tag_name;
+    if( attributes.hasAttribute("ID") )
+    {
+        ID = attributes.value("ID").toString();
+    }
+
+    PortModels ports_list;
+    ReadAttributePorts( attributes, ports_list );
+
+    // buildTreeNodeModelFromXML() inserts all the input ports first, then the
+    // output and the inout ones: keep the same priority for duplicated names.
+    const std::vector<std::pair<QLatin1String, PortDirection>> portsTypes = {
+        {QLatin1String("input_port"), PortDirection::INPUT},
+        {QLatin1String("output_port"), PortDirection::OUTPUT},
+        {QLatin1String("inout_port"), PortDirection::INOUT}};
+
+    std::vector<std::pair<QString, PortModel>> ports_by_type[3];
+
+    while( xml.readNextStartElement() )
+    {
+        size_t type_index = 0;
+        while( type_index < portsTypes.size() && xml.name() != portsTypes[type_index].first )
+        {
+            type_index++;
+        }
+        if( type_index == portsTypes.size() )
+        {
+            xml.skipCurrentElement();
+            continue;
+        }
+
+        const QXmlStreamAttributes port_attributes = xml.attributes();
+        PortModel port_model;
+        port_model.direction = portsTypes[type_index].second;
+
+        if( port_attributes.hasAttribute("type") )
+        {
+            port_model.type_name = port_attributes.value("type").toString();
+        }
+        if( port_attributes.hasAttribute("default") )
+        {
+            port_model.default_value = port_attributes.value("default").toString();
+        }
+        port_model.description = xml.readElementText( QXmlStreamReader::IncludeChildElements );
+
+        if( port_attributes.hasAttribute("name") )
+        {
+            ports_by_type[type_index].push_back( { port_attributes.value("name").toString(),
+                                                   std::move(port_model) } );
+        }
+    }
+
+    for(auto& ports: ports_by_type)
+    {
+        for(auto& port: ports)
+        {
+            ports_list.insert( std::move(port) );
+        }
+    }
+    return { node_type, ID, ports_list };
+}
+
+// The reader is at the start of the first node of the tree. It stops at the
+// end of the same node.
+void ReadTreeNodes(QXmlStreamReader& xml, AbsBehaviorTree& tree, NodeModels& implicit_models)
+{
+    std::vector<AbstractTreeNode*> parents;
+
+    while( true )
+    {
+        if( xml.isStartElement() )
+        {
+            const QString tag_name = xml.name().toString();
+            const QXmlStreamAttributes attributes = xml.attributes();
+
+            AbstractTreeNode tree_node;
+            tree_node.model.registration_ID = tag_name;
+            if( attributes.hasAttribute("ID") )
+            {
+                tree_node.model.registration_ID = attributes.value("ID").toString();
+            }
+
+            if( attributes.hasAttribute("name") )
+            {
+                tree_node.instance_name = attributes.value("name").toString();
+            }
+            else{
+                tree_node.instance_name = tree_node.model.registration_ID;
+            }
+
+            for(const auto& attr: attributes)
+            {
+                if( attr.name() != QLatin1String("ID") && attr.name() != QLatin1String("name") )
+                {
+                    tree_node.ports_mapping.insert( { attr.name().toString(), attr.value().toString() } );
+                }
+            }
+
+            // the models that are not in <TreeNodesModel> are deduced from the tree
+            const auto node_type = BT::convertFromString<BT::NodeType>(tag_name.toStdString());
+            if( node_type != NodeType::UNDEFINED &&
+                !tree_node.model.registration_ID.isEmpty() &&
+                implicit_models.count(tree_node.model.registration_ID) == 0 )
+            {
+                PortModels ports_list;
+                ReadAttributePorts( attributes, ports_list );
+                NodeModel model = { node_type, tree_node.model.registration_ID, ports_list };
+                implicit_models.insert( {model.registration_ID, model} );
+            }
+
+            AbstractTreeNode* parent = parents.empty() ? nullptr : parents.back();
+            parents.push_back( tree.addNode( parent, std::move(tree_node) ) );
+        }
+        else if( xml.isEndElement() )
+        {
+            parents.pop_back();
+            if( parents.empty() )
+            {
+                return;
+            }
+        }
+
+        if( xml.atEnd() )
+        {
+            return; // the error is reported by ReadProject()
+        }
+        xml.readNext();
+    }
+}
+
+// The reader is at the start of the <BehaviorTree>. The element is consumed.
+XmlTree ReadBehaviorTree(QXmlStreamReader& xml, NodeModels& implicit_models, bool& has_root_tag)
+{
+    XmlTree result;
+    result.ID = xml.attributes().value("ID").toString();
+
+    // as BuildTreeFromXML(), only the first child is considered
+    if( xml.readNextStartElement() )
+    {
+        if( xml.name() == QLatin1String("Root") )
+        {
+            has_root_tag = true;
+            if( xml.readNextStartElement() )
+            {
+                ReadTreeNodes( xml, result.tree, implicit_models );
+                xml.skipCurrentElement();
+            }
+        }
+        else{
+            ReadTreeNodes( xml, result.tree, implicit_models );
+        }
+        xml.skipCurrentElement();
+    }
+
+    if( result.tree.nodesCount() == 0 && !xml.hasError() )
+    {
+        throw std::runtime_error( (QString("The <BehaviorTree> %1 is empty").arg(result.ID)).toStdString() );
+    }
+    return result;
+}
+
+// The models of the trees are added to implicit_models.
+// Throws std::runtime_error if the XML is not well formed.
+void ReadProject(const QString &xml_text, XmlProject& project, NodeModels& implicit_models)
+{
+    QXmlStreamReader xml( xml_text );
+
+    if( xml.readNextStartElement() )
+    {
+        project.main_tree = xml.attributes().value("main_tree_to_execute").toString();
+
+        while( xml.readNextStartElement() )
+        {
+            if( xml.name() == QLatin1String("TreeNodesModel") )
+            {
+                while( xml.readNextStartElement() )
+                {
+                    auto model = ReadNodeModel( xml );
+                    project.models.insert( {model.registration_ID, model} );
+                }
+            }
+            else if( xml.name() == QLatin1String("BehaviorTree") )
+            {
+                project.trees.push_back( ReadBehaviorTree( xml, implicit_models, project.has_root_tag ) );
+            }
+            else{
+                xml.skipCurrentElement();
+            }
+        }
+    }
+    // anything after the root element must be well formed too
+    while( !xml.atEnd() )
+    {
+        xml.readNext();
+    }
+
+    if( xml.hasError() )
+    {
+        throw std::runtime_error( QString("Error parsing XML (line %1): %2")
+                                  .arg(xml.lineNumber()).arg(xml.errorString()).toStdString() );
+    }
+}
+
+// A <BehaviorTree> element of the file, read by a worker thread.
+struct TreeJob
+{
+    int begin;
+    int end;
+
+    XmlTree result;
+    NodeModels implicit_models;
+    bool has_root_tag;
+    bool failed;
+};
+
+// Quick scan of the markup that finds the <BehaviorTree> elements, to split
+// the work. It does not validate the document: it returns false when the
+// structure is not the one expected (or a DOCTYPE might declare entities).
+bool FindBehaviorTrees(const QString& xml_text, std::vector<TreeJob>& jobs)
+{
+    const QChar* data = xml_text.constData();
+    const int size = xml_text.size();
+
+    auto skipTo = [&](int from, const char* terminator) -> int
+    {
+        int pos = xml_text.indexOf( QLatin1String(terminator), from );
+        return (pos < 0) ? -1 : pos + int(strlen(terminator));
+    };
+
+    int depth = 0;
+    int tree_begin = -1;
+    int i = 0;
+    while( i < size )
+    {
+        if( data[i] != QLatin1Char('<') )
+        {
+            i++;
+            continue;
+        }
+        const QStringRef markup = xml_text.midRef(i, 9);
+        if( markup.startsWith( QLatin1String("<!--") ) )
+        {
+            i = skipTo( i + 4, "-->" );
+        }
+        else if( markup.startsWith( QLatin1String("<![CDATA[") ) )
+        {
+            i = skipTo( i + 9, "]]>" );
+        }
+        else if( markup.startsWith( QLatin1String("<?") ) )
+        {
+            i = skipTo( i + 2, "?>" );
+        }
+        else if( markup.startsWith( QLatin1String("<!") ) )
+        {
+            return false;
+        }
+        else{
+            const bool closing = ( i + 1 < size && data[i+1] == QLatin1Char('/') );
+            const int name_begin = closing ? i + 2 : i + 1;
+
+            // end of the tag, ignoring '>' inside the attribute values
+            int tag_end = name_begin;
+            QChar quote;
+            for( ; tag_end < size; tag_end++ )
+            {
+                const QChar c = data[tag_end];
+                if( !quote.isNull() )
+                {
+                    if( c == quote ) quote = QChar();
+                }
+                else if( c == QLatin1Char('"') || c == QLatin1Char('\'') )
+                {
+                    quote = c;
+                }
+                else if( c == QLatin1Char('>') )
+                {
+                    break;
+                }
+            }
+            if( tag_end == size )
+            {
+                return false;
+            }
+            int name_end = name_begin;
+            while( name_end < tag_end && !data[name_end].isSpace() &&
+                   data[name_end] != QLatin1Char('/') )
+            {
+                name_end++;
+            }
+            const bool is_tree = ( xml_text.midRef(name_begin, name_end - name_begin) ==
+                                   QLatin1String("BehaviorTree") );
+
+            if( closing )
+            {
+                depth--;
+                if( depth == 1 && tree_begin >= 0 )
+                {
+                    jobs.push_back( {tree_begin, tag_end + 1, XmlTree(), NodeModels(), false, false} );
+                    tree_begin = -1;
+                }
+            }
+            else if( data[tag_end - 1] == QLatin1Char('/') )
+            {
+                if( depth == 1 && is_tree )
+                {
+                    jobs.push_back( {i, tag_end + 1, XmlTree(), NodeModels(), false, false} );
+                }
+            }
+            else{
+                if( depth == 1 && is_tree )
+                {
+                    tree_begin = i;
+                }
+                depth++;
+            }
+            i = tag_end + 1;
+        }
+
+        if( i < 0 || depth < 0 )
+        {
+            return false;
+        }
+    }
+    return depth == 0;
+}
+
+// Returns false in case of error: the sequential parser will report it.
+bool ReadProjectConcurrently(const QString &xml_text, std::vector<TreeJob>& jobs, XmlProject& project)
+{
+    auto readTree = [&xml_text](TreeJob& job)
+    {
+        try{
+            // a <BehaviorTree> is a well formed document itself
+            QXmlStreamReader xml( xml_text.mid( job.begin, job.end - job.begin ) );
+            if( xml.readNextStartElement() )
+            {
+                job.result = ReadBehaviorTree( xml, job.implicit_models, job.has_root_tag );
+            }
+            while( !xml.atEnd() )
+            {
+                xml.readNext();
+            }
+            job.failed = xml.hasError() || job.result.tree.nodesCount() == 0;
+        }
+        catch( std::exception& )
+        {
+            job.failed = true;
+        }
+    };
+
+    QFuture<void> future = QtConcurrent::map( jobs, readTree );
+
+    // meanwhile, the rest of the document is read by this thread
+    QString skeleton;
+    skeleton.reserve( xml_text.size() );
+    int prev_end = 0;
+    for(const auto& job: jobs)
+    {
+        skeleton.append( xml_text.midRef(prev_end, job.begin - prev_end) );
+        prev_end = job.end;
+    }
+    skeleton.append( xml_text.midRef(prev_end) );
+
+    bool failed = false;
+    NodeModels implicit_models;
+    try{
+        ReadProject( skeleton, project, implicit_models );
+    }
+    catch( std::exception& )
+    {
+        failed = true;
+    }
+
+    future.waitForFinished();
+
+    for(auto& job: jobs)
+    {
+        failed = failed || job.failed;
+    }
+    if( failed )
+    {
+        return false;
+    }
+
+    // same priority of the sequential parser: the first model found is kept
+    project.trees.resize( jobs.size() );
+    for(size_t i=0; i < jobs.size(); i++)
+    {
+        auto& job = jobs[i];
+        project.models.insert( job.implicit_models.begin(), job.implicit_models.end() );
+        project.has_root_tag = project.has_root_tag || job.has_root_tag;
+        project.trees[i].ID = job.result.ID;
+        project.trees[i].tree.nodes().swap( job.result.tree.nodes() );
+    }
+    return true;
+}
+
+}
+
+XmlProject ReadProjectFromXML(const QString &xml_text)
+{
+    // one job for each <BehaviorTree>
+    std::vector<TreeJob> jobs;
+    if( FindBehaviorTrees( xml_text, jobs ) && jobs.size() > 1 )
+    {
+        XmlProject project;
+        if( ReadProjectConcurrently( xml_text, jobs, project ) )
+        {
+            return project;
+        }
+    }
+
+    XmlProject project;
+    NodeModels implicit_models;
+    ReadProject( xml_text, project, implicit_models );
+
+    // the models in <TreeNodesModel> have priority, wherever they are in the file
+    project.models.insert( implicit_models.begin(), implicit_models.end() );
+    return project;
+}
+
+void AssignTreeModels(AbsBehaviorTree& tree, const NodeModels& models)
+{
+    for(auto& tree_node: tree.nodes())
+    {
+        const QString modelID = tree_node.model.registration_ID;
+        auto model_it = models.find(modelID);
+        if( model_it ==  models.end() )
+        {
+             throw std::runtime_error( (QString("This model has not been registered: ") + modelID).toStdString() );
+        }
+        tree_node.model = model_it->second;
+    }
+}
+
+void AssignTreeModels(std::vector<XmlTree>& trees, const NodeModels& models)
+{
+    std::vector<std::string> errors( trees.size() );
+    XmlTree* first_tree = trees.data();
+
+    QtConcurrent::blockingMap( trees, [&](XmlTree& xml_tree)
+    {
+        try{
+            AssignTreeModels( xml_tree.tree, models );
+        }
+        catch( std::exception& err )
+        {
+            errors[ &xml_tree - first_tree ] = err.what();
+        }
+    });
+
+    for(const auto& error: errors)
+    {
+        if( !error.empty() )
+        {
+            throw std::runtime_error( error );
+        }
+    }
+}
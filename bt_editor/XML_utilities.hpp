@@ -2,6 +2,7 @@
 #define XMLPARSERS_HPP
 
 #include <QDomDocument>
+#include <QXmlStreamWriter>
 #include "bt_editor_base.h"
 
 #include <nodes/Node>
@@ -12,11 +13,17 @@
 
 NodeModels ReadTreeNodesModel(const QDomElement& root);
 
-void RecursivelyCreateXml(const QtNodes::FlowScene &scene,
-                          QDomDocument& doc,
-                          QDomElement& parent_element,
+/// Write the element of node and, recursively, of its children.
+/// Attributes are sorted by name.
+void RecursivelyCreateXml(QXmlStreamWriter& stream,
+                          const QtNodes::FlowScene &scene,
                           const QtNodes::Node* node);
 
+/// Same output of the function above, for a tree whose scene was not created.
+void RecursivelyCreateXml(QXmlStreamWriter& stream,
+                          const AbsBehaviorTree& tree,
+                          const AbstractTreeNode* node);
+
 bool VerifyXML(QDomDocument& doc,
                const std::vector<QString> &registered_ID,
                std::vector<QString> &error_messages);
@@ -25,5 +32,42 @@ NodeModel buildTreeNodeModelFromXML(const QDomElement &node);
 
 QDomElement writePortModel(const QString &port_name, const PortModel &port, QDomDocument &doc);
 
+/// Same output of the function above.
+void writePortModel(QXmlStreamWriter& stream, const QString &port_name, const PortModel &port);
+
+/// A <BehaviorTree> read by ReadProjectFromXML(). The nodes of the tree only
+/// have model.registration_ID: the models are assigned by AssignTreeModels().
+struct XmlTree
+{
+    QString ID; // empty if the attribute is missing
+    AbsBehaviorTree tree;
+};
+
+/// Content of a BehaviorTree project, read in a single pass without a DOM.
+struct XmlProject
+{
+    XmlProject(): has_root_tag(false) {}
+
+    QString main_tree; // attribute "main_tree_to_execute"
+
+    /// Same result of ReadTreeNodesModel().
+    NodeModels models;
+
+    std::vector<XmlTree> trees;
+
+    /// The deprecated node <Root> was found inside a <BehaviorTree>.
+    bool has_root_tag;
+};
+
+/// Throws std::runtime_error if the XML is not well formed.
+/// The <BehaviorTree> elements are read concurrently by the global QThreadPool.
+XmlProject ReadProjectFromXML(const QString& xml_text);
+
+/// Throws std::runtime_error if one of the models is not in the registry.
+void AssignTreeModels(AbsBehaviorTree& tree, const NodeModels& models);
+
+/// As above, one job for each tree. The error of the first tree is thrown.
+void AssignTreeModels(std::vector<XmlTree>& trees, const NodeModels& models);
+
 
 #endif // XMLPARSERS_HPP
@@ -0,0 +1,540 @@
+#include "autosave_journal.h"
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QtDebug>
+#include <algorithm>
+#include <cstdio>
+
+#ifdef Q_OS_WIN
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+const quint32 AUTOSAVE_MAGIC   = 0x47524153; // "GRAS"
+const quint32 AUTOSAVE_VERSION = 1;
+
+const char* CHECKPOINT_FILE = "checkpoint.bin";
+const char* TEMPORARY_FILE  = "checkpoint.tmp";
+const char* JOURNAL_FILE    = "journal.bin";
+const char* LOCK_FILE       = "autosave.lock";
+
+// a small journal is not worth a new checkpoint
+const qint64 MIN_JOURNAL_BYTES = 1024 * 1024;
+
+QString FilePath(const QString& directory, const char* name)
+{
+    return directory + QLatin1Char('/') + QLatin1String(name);
+}
+
+bool SameData(const QByteArray& a, const QByteArray& b)
+{
+    // the tabs that did not change share their data with the previous state
+    return ( a.constData() == b.constData() && a.size() == b.size() ) || a == b;
+}
+
+bool SyncFile(QFile& file)
+{
+    if( !file.flush() )
+    {
+        return false;
+    }
+#ifdef Q_OS_WIN
+    return _commit( file.handle() ) == 0;
+#else
+    return ::fsync( file.handle() ) == 0;
+#endif
+}
+
+void SyncDirectory(const QString& directory)
+{
+#ifndef Q_OS_WIN
+    int fd = ::open( QFile::encodeName(directory).constData(), O_RDONLY );
+    if( fd >= 0 )
+    {
+        ::fsync( fd );
+        ::close( fd );
+    }
+#else
+    Q_UNUSED(directory);
+#endif
+}
+
+bool ReplaceFile(const QString& from, const QString& to)
+{
+    // atomic on POSIX; Windows does not replace an existing file
+    if( std::rename( QFile::encodeName(from).constData(),
+                     QFile::encodeName(to).constData() ) == 0 )
+    {
+        return true;
+    }
+    QFile::remove( to );
+    return QFile::rename( from, to );
+}
+
+void WriteHeader(QDataStream& stream, quint32 generation)
+{
+    stream << AUTOSAVE_MAGIC << AUTOSAVE_VERSION << generation;
+}
+
+bool ReadHeader(QDataStream& stream, quint32& generation)
+{
+    quint32 magic = 0;
+    quint32 version = 0;
+    stream >> magic >> version >> generation;
+    return stream.status() == QDataStream::Ok &&
+           magic == AUTOSAVE_MAGIC && version == AUTOSAVE_VERSION;
+}
+
+// Each record is preceded by its size and checksum, to detect a partial write.
+void WriteFramed(QDataStream& stream, const QByteArray& payload)
+{
+    stream << quint32( payload.size() ) << qChecksum( payload.constData(), payload.size() );
+    stream.writeRawData( payload.constData(), payload.size() );
+}
+
+bool ReadFramed(QDataStream& stream, QByteArray& payload)
+{
+    quint32 size = 0;
+    quint16 checksum = 0;
+    stream >> size >> checksum;
+    if( stream.status() != QDataStream::Ok ||
+        qint64(size) > stream.device()->bytesAvailable() )
+    {
+        return false;
+    }
+    payload.resize( static_cast<int>(size) );
+    if( stream.readRawData( payload.data(), static_cast<int>(size) ) != static_cast<int>(size) )
+    {
+        return false;
+    }
+    return qChecksum( payload.constData(), payload.size() ) == checksum;
+}
+
+// Apply a record to state. Nothing is changed if the record is corrupted.
+bool ApplyRecord(const QByteArray& payload, AutosaveState& state)
+{
+    QDataStream stream( payload );
+    stream.setVersion( QDataStream::Qt_5_0 );
+
+    AutosaveState result;
+    bool models_changed = false;
+    stream >> result.main_tree >> result.current_tab_name >> models_changed;
+
+    if( models_changed )
+    {
+        quint32 count = 0;
+        stream >> count;
+        for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; i++)
+        {
+            NodeModel model;
+            stream >> model;
+            result.models.insert( {model.registration_ID, std::move(model)} );
+        }
+    }
+    else{
+        result.models = state.models;
+    }
+
+    quint32 count = 0;
+    stream >> count;
+    for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; i++)
+    {
+        QString name;
+        stream >> name;
+        auto it = state.scene_states.find( name );
+        result.scene_states[name] = (it != state.scene_states.end()) ? it->second : QByteArray();
+    }
+
+    stream >> count;
+    for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; i++)
+    {
+        QString name;
+        QByteArray binary;
+        stream >> name >> binary;
+        if( result.scene_states.count( name ) == 0 )
+        {
+            stream.setStatus( QDataStream::ReadCorruptData );
+        }
+        result.scene_states[name] = binary;
+    }
+
+    if( stream.status() != QDataStream::Ok )
+    {
+        return false;
+    }
+    state = std::move(result);
+    return true;
+}
+
+quint32 ReadGeneration(const QString& file_path)
+{
+    QFile file( file_path );
+    quint32 generation = 0;
+    if( file.open( QIODevice::ReadOnly ) )
+    {
+        QDataStream stream( &file );
+        stream.setVersion( QDataStream::Qt_5_0 );
+        if( !ReadHeader( stream, generation ) )
+        {
+            generation = 0;
+        }
+    }
+    return generation;
+}
+
+}
+
+AutosaveJournal::AutosaveJournal():
+    _stop_requested(false),
+    _write_failed(false),
+    _journal_generation(0),
+    _has_checkpoint(false),
+    _generation(0),
+    _checkpoint_bytes(0),
+    _journal_bytes(0)
+{
+}
+
+AutosaveJournal::~AutosaveJournal()
+{
+    stop();
+}
+
+bool AutosaveJournal::start(const QString &directory)
+{
+    stop();
+
+    if( !QDir().mkpath( directory ) )
+    {
+        return false;
+    }
+    _lock.reset( new QLockFile( FilePath(directory, LOCK_FILE) ) );
+    // the lock of a crashed instance is removed by tryLock()
+    if( !_lock->tryLock( 0 ) )
+    {
+        _lock.reset();
+        return false;
+    }
+
+    _directory = directory;
+    _last_state = AutosaveState();
+    _has_checkpoint = false;
+    _checkpoint_bytes = 0;
+    _journal_bytes = 0;
+    // the journal left by a crash must not match the next checkpoint
+    _generation = ReadGeneration( FilePath(directory, CHECKPOINT_FILE) );
+    _journal_generation = 0;
+    _write_failed = false;
+
+    _stop_requested = false;
+    _thread = std::thread( &AutosaveJournal::writeLoop, this );
+    return true;
+}
+
+void AutosaveJournal::stop()
+{
+    joinThread();
+    _lock.reset();
+}
+
+void AutosaveJournal::joinThread()
+{
+    if( _thread.joinable() )
+    {
+        {
+            std::lock_guard<std::mutex> lock( _mutex );
+            _stop_requested = true;
+        }
+        _condition.notify_one();
+        _thread.join();
+    }
+}
+
+void AutosaveJournal::discard()
+{
+    if( !_lock )
+    {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock( _mutex );
+        _records.clear();
+    }
+    joinThread();
+
+    QFile::remove( FilePath(_directory, CHECKPOINT_FILE) );
+    QFile::remove( FilePath(_directory, TEMPORARY_FILE) );
+    QFile::remove( FilePath(_directory, JOURNAL_FILE) );
+    _lock.reset();
+}
+
+void AutosaveJournal::submit(const AutosaveState &state)
+{
+    if( !isRunning() )
+    {
+        return;
+    }
+
+    // what is on disk is older than _last_state: write everything again
+    if( _write_failed.exchange( false ) )
+    {
+        _has_checkpoint = false;
+    }
+
+    Record record;
+    record.models_changed = !_has_checkpoint || state.models != _last_state.models;
+
+    qint64 changed_bytes = 0;
+    for (const auto& it: state.scene_states)
+    {
+        auto prev_it = _last_state.scene_states.find( it.first );
+        if( !_has_checkpoint || prev_it == _last_state.scene_states.end() ||
+            !SameData( prev_it->second, it.second ) )
+        {
+            record.changed_tabs.push_back( it.first );
+            changed_bytes += it.second.size();
+        }
+    }
+
+    const bool unchanged = _has_checkpoint && !record.models_changed &&
+                           record.changed_tabs.empty() &&
+                           state.scene_states.size() == _last_state.scene_states.size() &&
+                           state.main_tree == _last_state.main_tree &&
+                           state.current_tab_name == _last_state.current_tab_name;
+    if( unchanged )
+    {
+        return;
+    }
+
+    record.checkpoint = !_has_checkpoint ||
+            _journal_bytes + changed_bytes > std::max( _checkpoint_bytes, MIN_JOURNAL_BYTES );
+
+    if( record.checkpoint )
+    {
+        _generation++;
+        _has_checkpoint = true;
+        _journal_bytes = 0;
+        _checkpoint_bytes = 0;
+        record.models_changed = true;
+        record.changed_tabs.clear();
+        for (const auto& it: state.scene_states)
+        {
+            record.changed_tabs.push_back( it.first );
+            _checkpoint_bytes += it.second.size();
+        }
+    }
+    else{
+        _journal_bytes += changed_bytes;
+    }
+    record.generation = _generation;
+    record.state = state;
+    _last_state = state;
+
+    {
+        std::lock_guard<std::mutex> lock( _mutex );
+        if( record.checkpoint )
+        {
+            // whatever is still waiting is included in the checkpoint
+            _records.clear();
+        }
+        _records.push_back( std::move(record) );
+    }
+    _condition.notify_one();
+}
+
+void AutosaveJournal::writeLoop()
+{
+    std::unique_lock<std::mutex> lock( _mutex );
+    while( true )
+    {
+        _condition.wait( lock, [this]() { return _stop_requested || !_records.empty(); } );
+        if( _records.empty() )
+        {
+            break; // stop requested and everything written
+        }
+        Record record = std::move( _records.front() );
+        _records.pop_front();
+        lock.unlock();
+
+        if( record.checkpoint )
+        {
+            writeCheckpoint( record );
+        }
+        else{
+            appendToJournal( record );
+        }
+        lock.lock();
+    }
+}
+
+namespace {
+
+QByteArray SerializeRecord(const AutosaveState& state,
+                           const std::vector<QString>& changed_tabs,
+                           bool models_changed)
+{
+    QByteArray payload;
+    QDataStream stream( &payload, QIODevice::WriteOnly );
+    stream.setVersion( QDataStream::Qt_5_0 );
+
+    stream << state.main_tree << state.current_tab_name << models_changed;
+    if( models_changed )
+    {
+        stream << quint32( state.models.size() );
+        for (const auto& it: state.models)
+        {
+            stream << it.second;
+        }
+    }
+
+    stream << quint32( state.scene_states.size() );
+    for (const auto& it: state.scene_states)
+    {
+        stream << it.first;
+    }
+
+    stream << quint32( changed_tabs.size() );
+    for (const auto& name: changed_tabs)
+    {
+        stream << name << state.scene_states.at( name );
+    }
+    return payload;
+}
+
+}
+
+void AutosaveJournal::writeCheckpoint(const Record &record)
+{
+    const QByteArray payload = SerializeRecord( record.state, record.changed_tabs, true );
+
+    // Until the new checkpoint is written, the records of its generation must
+    // not be appended to the journal of the previous one.
+    _journal_generation = 0;
+
+    QFile file( FilePath(_directory, TEMPORARY_FILE) );
+    if( !file.open( QIODevice::WriteOnly | QIODevice::Truncate ) )
+    {
+        qDebug() << "Autosave: can not write " << file.fileName();
+        _write_failed = true;
+        return;
+    }
+    {
+        QDataStream stream( &file );
+        stream.setVersion( QDataStream::Qt_5_0 );
+        WriteHeader( stream, record.generation );
+        WriteFramed( stream, payload );
+    }
+    const bool synced = SyncFile( file );
+    file.close();
+
+    if( !synced || !ReplaceFile( file.fileName(), FilePath(_directory, CHECKPOINT_FILE) ) )
+    {
+        qDebug() << "Autosave: failed to write the checkpoint";
+        QFile::remove( file.fileName() );
+        _write_failed = true;
+        return;
+    }
+    SyncDirectory( _directory );
+
+    // the previous journal has an older generation: it is ignored even if
+    // a crash happens before it is truncated.
+    QFile journal( FilePath(_directory, JOURNAL_FILE) );
+    if( !journal.open( QIODevice::WriteOnly | QIODevice::Truncate ) )
+    {
+        qDebug() << "Autosave: can not write " << journal.fileName();
+        _write_failed = true;
+        return;
+    }
+    {
+        QDataStream stream( &journal );
+        stream.setVersion( QDataStream::Qt_5_0 );
+        WriteHeader( stream, record.generation );
+    }
+    if( !SyncFile( journal ) )
+    {
+        qDebug() << "Autosave: failed to sync " << journal.fileName();
+        _write_failed = true;
+        return;
+    }
+    _journal_generation = record.generation;
+}
+
+void AutosaveJournal::appendToJournal(const Record &record)
+{
+    // the checkpoint of this record, or one of the records before it, was not written
+    if( record.generation != _journal_generation )
+    {
+        _write_failed = true;
+        return;
+    }
+
+    const QByteArray payload = SerializeRecord( record.state, record.changed_tabs,
+                                                record.models_changed );
+
+    QFile journal( FilePath(_directory, JOURNAL_FILE) );
+    if( !journal.open( QIODevice::WriteOnly | QIODevice::Append ) )
+    {
+        qDebug() << "Autosave: can not write " << journal.fileName();
+        _journal_generation = 0;
+        _write_failed = true;
+        return;
+    }
+    QDataStream stream( &journal );
+    stream.setVersion( QDataStream::Qt_5_0 );
+    WriteFramed( stream, payload );
+    if( !SyncFile( journal ) )
+    {
+        qDebug() << "Autosave: failed to sync " << journal.fileName();
+        _journal_generation = 0;
+        _write_failed = true;
+    }
+}
+
+bool AutosaveJournal::recover(const QString &directory, AutosaveState &state)
+{
+    QFile checkpoint( FilePath(directory, CHECKPOINT_FILE) );
+    if( !checkpoint.open( QIODevice::ReadOnly ) )
+    {
+        return false;
+    }
+    QDataStream stream( &checkpoint );
+    stream.setVersion( QDataStream::Qt_5_0 );
+
+    quint32 generation = 0;
+    QByteArray payload;
+    AutosaveState result;
+    if( !ReadHeader( stream, generation ) || !ReadFramed( stream, payload ) ||
+        !ApplyRecord( payload, result ) )
+    {
+        return false;
+    }
+
+    QFile journal( FilePath(directory, JOURNAL_FILE) );
+    if( journal.open( QIODevice::ReadOnly ) )
+    {
+        QDataStream journal_stream( &journal );
+        journal_stream.setVersion( QDataStream::Qt_5_0 );
+
+        quint32 journal_generation = 0;
+        if( ReadHeader( journal_stream, journal_generation ) && journal_generation == generation )
+        {
+            // stop at the first record that was not completely written
+            while( !journal_stream.atEnd() && ReadFramed( journal_stream, payload ) &&
+                   ApplyRecord( payload, result ) )
+            {
+            }
+        }
+    }
+
+    if( result.scene_states.empty() )
+    {
+        return false;
+    }
+    state = std::move(result);
+    return true;
+}
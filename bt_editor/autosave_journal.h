@@ -0,0 +1,104 @@
+#ifndef AUTOSAVE_JOURNAL_H
+#define AUTOSAVE_JOURNAL_H
+
+#include <QByteArray>
+#include <QLockFile>
+#include <QString>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "bt_editor_base.h"
+
+/// What is needed to restore the editor after a crash.
+struct AutosaveState
+{
+    QString main_tree;
+    QString current_tab_name;
+    NodeModels models;                          // without the builtin ones
+    std::map<QString, QByteArray> scene_states; // GraphicContainer::saveToBinary() of each tab
+};
+
+/// Writes the AutosaveState of the editor into a directory, from a dedicated thread.
+///
+/// A checkpoint with the whole state is followed by an append-only journal
+/// that contains only the tabs changed by each submit(). Every write is synced
+/// to disk before the next one; a record truncated by a crash is discarded when
+/// the journal is read again. When the journal grows larger than the checkpoint,
+/// a new checkpoint replaces both. After a failed write nothing is appended
+/// to the journal until a new checkpoint is written.
+class AutosaveJournal
+{
+public:
+    AutosaveJournal();
+    ~AutosaveJournal();
+
+    /// Lock the directory and start the writing thread. Returns false if the
+    /// directory can not be created or it is used by another instance of Groot.
+    bool start(const QString& directory);
+
+    /// Write what was already submitted, then stop the thread.
+    /// The files are kept, to be read by recover().
+    void stop();
+
+    /// Stop and remove the files: to be called when the application exits normally.
+    void discard();
+
+    bool isRunning() const { return _thread.joinable(); }
+
+    /// To be called from the GUI thread. The content of the tabs is shared with
+    /// state, not copied; it is serialized by the writing thread.
+    void submit(const AutosaveState& state);
+
+    /// Read what was written in directory by a previous instance.
+    /// Returns false if there is nothing to recover.
+    static bool recover(const QString& directory, AutosaveState& state);
+
+private:
+    struct Record
+    {
+        bool checkpoint;
+        quint32 generation;
+        AutosaveState state;
+        std::vector<QString> changed_tabs; // all of them in a checkpoint
+        bool models_changed;
+    };
+
+    void joinThread();
+
+    void writeLoop();
+
+    void writeCheckpoint(const Record& record);
+
+    void appendToJournal(const Record& record);
+
+    QString _directory;
+    std::unique_ptr<QLockFile> _lock;
+
+    std::thread _thread;
+    std::mutex _mutex;
+    std::condition_variable _condition;
+    std::deque<Record> _records;
+    bool _stop_requested;
+    // set by the writing thread when a record was not written:
+    // the next submit() is a checkpoint
+    std::atomic<bool> _write_failed;
+
+    // used by the writing thread only: the generation of the checkpoint
+    // that the journal refers to, 0 if nothing can be appended to it
+    quint32 _journal_generation;
+
+    // used by the GUI thread only
+    AutosaveState _last_state;
+    bool _has_checkpoint;
+    quint32 _generation;
+    qint64 _checkpoint_bytes;
+    qint64 _journal_bytes;
+};
+
+#endif // AUTOSAVE_JOURNAL_H
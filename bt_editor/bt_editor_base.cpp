@@ -113,6 +113,127 @@ bool AbsBehaviorTree::operator ==(const AbsBehaviorTree &other) const
 }
 
 
+QDataStream &operator <<(QDataStream &stream, const NodeModel &model)
+{
+    stream << qint32( model.type ) << model.registration_ID << quint32( model.ports.size() );
+    for (const auto& port_it: model.ports)
+    {
+        const PortModel& port = port_it.second;
+        stream << port_it.first << port.type_name << qint32( port.direction )
+               << port.description << port.default_value;
+    }
+    return stream;
+}
+
+QDataStream &operator >>(QDataStream &stream, NodeModel &model)
+{
+    qint32 type;
+    quint32 ports_count = 0;
+    stream >> type >> model.registration_ID >> ports_count;
+    model.type = static_cast<NodeType>( type );
+
+    model.ports.clear();
+    for (quint32 p = 0; p < ports_count && stream.status() == QDataStream::Ok; p++)
+    {
+        QString port_name;
+        PortModel port;
+        qint32 direction;
+        stream >> port_name >> port.type_name >> direction
+               >> port.description >> port.default_value;
+        port.direction = static_cast<PortDirection>( direction );
+        model.ports.insert( {port_name, std::move(port)} );
+    }
+    return stream;
+}
+
+void AbsBehaviorTree::saveBinary(QDataStream &stream) const
+{
+    // the same model is used by many nodes: save it once
+    std::map<QString, const NodeModel*> models;
+    for (const auto& node: _nodes)
+    {
+        models.insert( {node.model.registration_ID, &node.model} );
+    }
+
+    stream << quint32( models.size() );
+    for (const auto& it: models)
+    {
+        stream << *it.second;
+    }
+
+    stream << quint32( _nodes.size() );
+    for (const auto& node: _nodes)
+    {
+        stream << node.model.registration_ID << node.instance_name;
+        stream << quint32( node.ports_mapping.size() );
+        for (const auto& it: node.ports_mapping)
+        {
+            stream << it.first << it.second;
+        }
+        stream << quint32( node.children_index.size() );
+        for (int index: node.children_index)
+        {
+            stream << qint32( index );
+        }
+    }
+}
+
+void AbsBehaviorTree::restoreBinary(QDataStream &stream)
+{
+    clear();
+
+    quint32 models_count = 0;
+    stream >> models_count;
+    std::map<QString, NodeModel> models;
+    for (quint32 m = 0; m < models_count && stream.status() == QDataStream::Ok; m++)
+    {
+        NodeModel model;
+        stream >> model;
+        models.insert( {model.registration_ID, std::move(model)} );
+    }
+
+    quint32 nodes_count = 0;
+    stream >> nodes_count;
+    for (quint32 n = 0; n < nodes_count && stream.status() == QDataStream::Ok; n++)
+    {
+        AbstractTreeNode node;
+        QString model_ID;
+        stream >> model_ID >> node.instance_name;
+        auto model_it = models.find( model_ID );
+        if( model_it != models.end() )
+        {
+            node.model = model_it->second;
+        }
+
+        quint32 count = 0;
+        stream >> count;
+        for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; i++)
+        {
+            QString port_name, value;
+            stream >> port_name >> value;
+            node.ports_mapping.insert( {port_name, value} );
+        }
+        stream >> count;
+        for (quint32 i = 0; i < count && stream.status() == QDataStream::Ok; i++)
+        {
+            qint32 index;
+            stream >> index;
+            if( index <= qint32(n) || quint32(index) >= nodes_count )
+            {
+                stream.setStatus( QDataStream::ReadCorruptData );
+            }
+            node.children_index.push_back( index );
+        }
+        node.index = static_cast<int>( n );
+        _nodes.push_back( std::move(node) );
+    }
+
+    if( stream.status() != QDataStream::Ok )
+    {
+        clear();
+        throw std::runtime_error( "AbsBehaviorTree::restoreBinary: truncated or corrupted data" );
+    }
+}
 
 GraphicMode getGraphicModeFromString(const QString &str)
 {
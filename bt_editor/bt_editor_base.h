@@ -2,6 +2,7 @@
 #define BT_EDITOR_BASE_H
 
 #include <QString>
+#include <QDataStream>
 #include <QPointF>
 #include <QSizeF>
 #include <map>
@@ -48,6 +49,10 @@ struct  NodeModel
 
 typedef std::map<QString, NodeModel> NodeModels;
 
+QDataStream& operator <<(QDataStream& stream, const NodeModel& model);
+
+QDataStream& operator >>(QDataStream& stream, NodeModel& model);
+
 
 enum class GraphicMode { EDITOR, MONITOR, REPLAY };
 
@@ -128,6 +133,12 @@ public:
 
     void clear();
 
+    /// Models, names, port remapping and hierarchy. Status, positions, sizes
+    /// and graphic nodes are not saved.
+    void saveBinary(QDataStream& stream) const;
+
+    void restoreBinary(QDataStream& stream);
+
 private:
     NodesVector _nodes;
 };
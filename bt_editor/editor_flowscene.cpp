@@ -14,7 +14,8 @@
 EditorFlowScene::EditorFlowScene(std::shared_ptr<QtNodes::DataModelRegistry> registry,
                                  QObject * parent):
     FlowScene(registry,parent),
-    _editor_locked(false)
+    _editor_locked(false),
+    _topology( new TreeTopology(*this) )
 {
 
 }
@@ -4,6 +4,7 @@
 #include <nodes/FlowScene>
 #include <nodes/DataModelRegistry>
 #include "bt_editor/bt_editor_base.h"
+#include "bt_editor/tree_topology.h"
 
 class EditorFlowScene : public QtNodes::FlowScene
 {
@@ -16,6 +17,8 @@ public:
 
     QtNodes::Node& createNodeAtPos(const QString& ID, const QString& instance_name, QPointF scene_pos);
 
+    const TreeTopology& topology() const { return *_topology; }
+
 private:
 
     void dragEnterEvent(QGraphicsSceneDragDropEvent *event) override;
@@ -26,6 +29,7 @@ private:
     void keyPressEvent( QKeyEvent * event ) override;
 
     bool _editor_locked;
+    TreeTopology* _topology; // child of this
     AbstractTreeNode _clipboard_node;
 };
 
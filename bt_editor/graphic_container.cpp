@@ -15,11 +15,22 @@
 
 using namespace QtNodes;
 
+namespace {
+quint64 last_revision = 0;
+
+// header of the trees saved by GraphicContainer::saveToBinary()
+const quint32 PendingTreeMagic = 0x47525442; // "GRTB"
+}
+
 GraphicContainer::GraphicContainer(std::shared_ptr<DataModelRegistry> model_registry,
                                    QWidget *parent) :
     QObject(parent),
     _model_registry( std::move(model_registry) ),
-    _signal_was_blocked(true)
+    _signal_was_blocked(true),
+    _indexed_nodes_valid(false),
+    _revision( ++last_revision ),
+    _has_pending_tree(false),
+    _editing_locked(false)
 {
     _scene = new EditorFlowScene( _model_registry, parent );
     _view  = new QtNodes::FlowView( _scene, parent );
@@ -68,10 +79,72 @@ GraphicContainer::GraphicContainer(std::shared_ptr<DataModelRegistry> model_regi
         }
     });
 
+    // any structural change may modify the indexing of the nodes
+    connect( _scene, &QtNodes::FlowScene::nodeCreated,
+             this, &GraphicContainer::invalidateIndexedNodes );
+    connect( _scene, &QtNodes::FlowScene::nodeDeleted,
+             this, &GraphicContainer::invalidateIndexedNodes );
+    connect( _scene, &QtNodes::FlowScene::nodeMoved,
+             this, &GraphicContainer::invalidateIndexedNodes );
+    connect( _scene, &QtNodes::FlowScene::connectionCreated,
+             this, &GraphicContainer::invalidateIndexedNodes );
+    connect( _scene, &QtNodes::FlowScene::connectionDeleted,
+             this, &GraphicContainer::invalidateIndexedNodes );
+
+    connect( this, &GraphicContainer::undoableChange,
+             this, &GraphicContainer::markChanged );
+    // unlike undoableChange, these are emitted even when this object is blocked
+    connect( _scene, &QtNodes::FlowScene::nodeCreated,
+             this, &GraphicContainer::markChanged );
+    connect( _scene, &QtNodes::FlowScene::nodeDeleted,
+             this, &GraphicContainer::markChanged );
+    connect( _scene, &QtNodes::FlowScene::nodeMoved,
+             this, &GraphicContainer::markChanged );
+    connect( _scene, &QtNodes::FlowScene::connectionCreated,
+             this, &GraphicContainer::markChanged );
+    connect( _scene, &QtNodes::FlowScene::connectionDeleted,
+             this, &GraphicContainer::markChanged );
+}
+
+void GraphicContainer::markChanged()
+{
+    _revision = ++last_revision;
+}
+
+void GraphicContainer::loadTreeLazily(const AbsBehaviorTree &tree)
+{
+    clearScene();
+    _pending_tree = tree;
+    _has_pending_tree = true;
+    markChanged();
+}
+
+void GraphicContainer::materialize()
+{
+    if( !_has_pending_tree )
+    {
+        return;
+    }
+    _has_pending_tree = false;
+    AbsBehaviorTree tree;
+    tree.nodes().swap( _pending_tree.nodes() );
+    {
+        const QSignalBlocker blocker( this );
+        loadSceneFromTree( tree );
+        nodeReorder();
+        if( _editing_locked )
+        {
+            lockEditing( true );
+        }
+    }
+    const bool was_blocked = blockSignals( false );
+    emit materialized();
+    blockSignals( was_blocked );
 }
 
 void GraphicContainer::lockEditing(bool locked)
 {
+    _editing_locked = locked;
     std::vector<QtNodes::Node*> subtrees_expanded;
     for (auto& nodes_it: _scene->nodes() )
     {
@@ -128,10 +201,10 @@ void GraphicContainer::lockSubtreeEditing(Node &root_node, bool locked, bool cha
             bt_model->lock(locked);
         }
 
-        auto connections = node->nodeState().getEntries(PortType::Out);
-        for (auto& conn_by_port: connections )
+        const auto& connections = node->nodeState().getEntries(PortType::Out);
+        for (const auto& conn_by_port: connections )
         {
-            for (auto& conn_it: conn_by_port )
+            for (const auto& conn_it: conn_by_port )
             {
                 QtNodes::Connection* conn = conn_it.second;
                 conn->connectionGraphicsObject().lock( locked );
@@ -154,15 +227,48 @@ void GraphicContainer::lockSubtreeEditing(Node &root_node, bool locked, bool cha
 
 void GraphicContainer::nodeReorder()
 {
+    materialize();
     {
         const QSignalBlocker blocker(this);
         auto abstract_tree = BuildTreeFromScene( _scene );
         NodeReorder( *_scene, abstract_tree );
+        markChanged();
         zoomHomeView();
     }
     emit undoableChange();
 }
 
+void GraphicContainer::nodeReorder(Node &subtree_root)
+{
+    materialize();
+    {
+        const QSignalBlocker blocker(this);
+        auto abstract_tree = BuildTreeFromScene( _scene );
+        SubtreeReorder( *_scene, abstract_tree, subtree_root );
+        markChanged();
+    }
+    emit undoableChange();
+}
+
+bool GraphicContainer::setPortLayout(QtNodes::PortLayout layout)
+{
+    if( _scene->layout() == layout )
+    {
+        return false;
+    }
+    if( _has_pending_tree )
+    {
+        // the scene is still empty: materialize() lays out the nodes with it
+        _scene->setLayout( layout );
+        return false;
+    }
+    auto abstract_tree = BuildTreeFromScene( _scene );
+    _scene->setLayout( layout );
+    NodeReorder( *_scene, abstract_tree );
+    markChanged();
+    return true;
+}
+
 void GraphicContainer::saveSvgFile(const QString path)
 {
     QSvgGenerator generator;
@@ -189,10 +295,30 @@ void GraphicContainer::zoomHomeView()
     _view->setSceneRect (rect);
     _view->fitInView(rect, Qt::KeepAspectRatio);
     _view->scale(0.9, 0.9);
+    _view->updateLevelOfDetail();
 }
 
 bool GraphicContainer::containsValidTree() const
 {
+    if( _has_pending_tree )
+    {
+        // same rules applied below to the ports of the nodes
+        for(const auto& abs_node: _pending_tree.nodes())
+        {
+            const auto type = abs_node.model.type;
+            bool has_output = ( type != NodeType::ACTION && type != NodeType::CONDITION );
+            if( type == NodeType::SUBTREE )
+            {
+                has_output = ( abs_node.children_index.size() == 1 ); // expanded
+            }
+            if( has_output && abs_node.children_index.empty() )
+            {
+                return false;
+            }
+        }
+        return _pending_tree.nodesCount() > 0;
+    }
+
     if( _scene->nodes().empty())
     {
         return false;
@@ -240,7 +366,43 @@ bool GraphicContainer::containsValidTree() const
 void GraphicContainer::clearScene()
 {
     const QSignalBlocker blocker( this );
+    _pending_tree.clear();
+    _has_pending_tree = false;
     _scene->clearScene();
+    invalidateIndexedNodes();
+}
+
+AbsBehaviorTree GraphicContainer::loadedTree() const
+{
+    if( _has_pending_tree )
+    {
+        return _pending_tree;
+    }
+    return BuildTreeFromScene( _scene );
+}
+
+const std::vector<GraphicContainer::IndexedNode> &GraphicContainer::indexedNodes()
+{
+    materialize();
+    if( !_indexed_nodes_valid )
+    {
+        auto tree = BuildTreeFromScene( _scene );
+
+        _indexed_nodes.resize( tree.nodesCount() );
+        for(const auto& abs_node: tree.nodes())
+        {
+            _indexed_nodes[abs_node.index] = { abs_node.graphic_node, -1 };
+        }
+        for(const auto& abs_node: tree.nodes())
+        {
+            for(int child_index: abs_node.children_index)
+            {
+                _indexed_nodes[child_index].parent_index = abs_node.index;
+            }
+        }
+        _indexed_nodes_valid = true;
+    }
+    return _indexed_nodes;
 }
 
 
@@ -334,6 +496,11 @@ void GraphicContainer::onNodeCreated(Node &node)
 {
     if( auto bt_node = dynamic_cast<BehaviorTreeDataModel*>( node.nodeDataModel() ) )
     {
+        connect( bt_node, &BehaviorTreeDataModel::parameterUpdated,
+                 this, &GraphicContainer::markChanged );
+        connect( bt_node, &BehaviorTreeDataModel::instanceNameChanged,
+                 this, &GraphicContainer::markChanged );
+
         connect( bt_node, &BehaviorTreeDataModel::parameterUpdated,
                  this, &GraphicContainer::undoableChange );
 
@@ -443,8 +610,8 @@ QtNodes::Node* GraphicContainer::substituteNode(Node *old_node, const QString& n
     if( old_node->nodeDataModel()->nPorts( PortType::In ) == 1 &&
         new_node.nodeDataModel()->nPorts( PortType::In ) == 1 )
     {
-        auto conn_in  = old_node->nodeState().connections(PortType::In, 0);
-        for(auto it: conn_in)
+        const auto& conn_in  = old_node->nodeState().connections(PortType::In, 0);
+        for(const auto& it: conn_in)
         {
             auto child_node = it.second->getNode(PortType::Out);
             _scene->createConnection( new_node, 0, *child_node, 0 );
@@ -454,8 +621,8 @@ QtNodes::Node* GraphicContainer::substituteNode(Node *old_node, const QString& n
     if( old_node->nodeDataModel()->nPorts( PortType::Out ) == 1 &&
         new_node.nodeDataModel()->nPorts( PortType::Out ) == 1 )
     {
-        auto conn_in  = old_node->nodeState().connections(PortType::Out, 0);
-        for(auto it: conn_in)
+        const auto& conn_in  = old_node->nodeState().connections(PortType::Out, 0);
+        for(const auto& it: conn_in)
         {
             auto child_node = it.second->getNode(PortType::In);
             _scene->createConnection( *child_node, 0, new_node, 0 );
@@ -466,15 +633,56 @@ QtNodes::Node* GraphicContainer::substituteNode(Node *old_node, const QString& n
     return &new_node;
 }
 
+bool GraphicContainer::substitutePendingModel(const QString &prev_ID,
+                                              const NodeModel &new_model)
+{
+    if( !_has_pending_tree )
+    {
+        return false;
+    }
+    bool changed = false;
+    for(auto& abs_node: _pending_tree.nodes())
+    {
+        if( abs_node.model.registration_ID != prev_ID )
+        {
+            continue;
+        }
+        // as in substituteNode(): keep an edited instance name and the
+        // remapped ports that the new model still has
+        if( abs_node.instance_name == abs_node.model.registration_ID ||
+            new_model.type == NodeType::SUBTREE )
+        {
+            abs_node.instance_name = new_model.registration_ID;
+        }
+        PortsMapping ports_mapping;
+        for(const auto& port_it: abs_node.ports_mapping)
+        {
+            if( !port_it.second.isEmpty() && new_model.ports.count( port_it.first ) )
+            {
+                ports_mapping.insert( port_it );
+            }
+        }
+        abs_node.ports_mapping = std::move(ports_mapping);
+        abs_node.model = new_model;
+        changed = true;
+    }
+    if( changed )
+    {
+        markChanged();
+    }
+    return true;
+}
+
 void GraphicContainer::deleteSubTreeRecursively(Node &root_node)
 {
-    const QSignalBlocker blocker1( this );
-    const QSignalBlocker blocker2( _scene );
+    // the signals of the scene keep its TreeTopology up to date: do not block them
+    const QSignalBlocker blocker( this );
     auto nodes_to_delete = getSubtreeNodesRecursively(root_node);
     for(auto delete_me: nodes_to_delete)
     {
         _scene->removeNode( *delete_me );
     }
+    invalidateIndexedNodes();
 }
 
 
@@ -513,8 +721,8 @@ void GraphicContainer::createSmartRemoveAction(QtNodes::Node &node, QMenu* node_
     auto *smart_remove = new QAction("Smart Remove ", node_menu);
     node_menu->addAction(smart_remove);
 
-    NodeState::ConnectionPtrSet conn_in  = node.nodeState().connections(PortType::In, 0);
-    NodeState::ConnectionPtrSet conn_out = node.nodeState().connections(PortType::Out, 0);
+    const NodeState::ConnectionPtrSet& conn_in  = node.nodeState().connections(PortType::In, 0);
+    const NodeState::ConnectionPtrSet& conn_out = node.nodeState().connections(PortType::Out, 0);
 
     if( conn_in.size() != 1 || conn_out.size() == 0 )
     {
@@ -542,7 +750,7 @@ void GraphicContainer::createSmartRemoveAction(QtNodes::Node &node, QMenu* node_
 void GraphicContainer::onSmartRemove(QtNodes::Node* node)
 {
     auto parent_node = GetParentNode( node );
-    NodeState::ConnectionPtrSet conn_out = node->nodeState().connections(PortType::Out, 0);
+    const NodeState::ConnectionPtrSet& conn_out = node->nodeState().connections(PortType::Out, 0);
 
     if( !parent_node || conn_out.size() == 0 )
     {
@@ -557,7 +765,7 @@ void GraphicContainer::onSmartRemove(QtNodes::Node* node)
             _scene->createConnection( *child_node, 0, *parent_node, 0 );
         }
         _scene->removeNode( *node );
-        nodeReorder();
+        nodeReorder( *parent_node );
     }
     undoableChange();
 }
@@ -578,7 +786,7 @@ void GraphicContainer::insertNodeInConnection(Connection &connection, QString no
         _scene->deleteConnection(connection);
         _scene->createConnection(*child_node, 0, inserted_node, 0);
         _scene->createConnection(inserted_node, 0, *parent_node, 0);
-        nodeReorder();
+        nodeReorder( *parent_node );
     }
     undoableChange();
 }
@@ -693,6 +901,7 @@ void GraphicContainer::loadSceneFromTree(const AbsBehaviorTree &tree)
 
     recursiveLoadStep(cursor, abs_tree, root_node, &first_qt_node, 1 );
     NodeReorder( *_scene, abs_tree );
+    markChanged();
 }
 
 void GraphicContainer::appendTreeToNode(Node &node, AbsBehaviorTree& subtree)
@@ -727,9 +936,35 @@ void GraphicContainer::appendTreeToNode(Node &node, AbsBehaviorTree& subtree)
     recursiveLoadStep(cursor, subtree, root_node , &node, 1 );
 }
 
-void GraphicContainer::loadFromJson(const QByteArray &data)
+void GraphicContainer::loadFromBinary(const QByteArray &data)
 {
     const QSignalBlocker blocker( this );
     clearScene();
-    scene()->loadFromMemory( data );
+
+    QDataStream stream( data );
+    stream.setVersion( FlowScene::BinaryStreamVersion );
+    quint32 magic = 0;
+    stream >> magic;
+    if( magic == PendingTreeMagic )
+    {
+        AbsBehaviorTree tree;
+        tree.restoreBinary( stream );
+        loadTreeLazily( tree );
+        return;
+    }
+    _scene->loadFromBinary( data );
+}
+
+QByteArray GraphicContainer::saveToBinary() const
+{
+    if( !_has_pending_tree )
+    {
+        return _scene->saveToBinary();
+    }
+    QByteArray data;
+    QDataStream stream( &data, QIODevice::WriteOnly );
+    stream.setVersion( FlowScene::BinaryStreamVersion );
+    stream << PendingTreeMagic;
+    _pending_tree.saveBinary( stream );
+    return data;
 }
@@ -21,18 +21,37 @@ public:
     explicit GraphicContainer(std::shared_ptr<QtNodes::DataModelRegistry> registry,
                               QWidget *parent = nullptr);
 
-    EditorFlowScene* scene() { return _scene; }
+    /// The nodes of a tree loaded with loadTreeLazily() are created here,
+    /// the first time the scene is needed.
+    EditorFlowScene* scene() { materialize(); return _scene; }
     QtNodes::FlowView*  view() { return _view; }
 
     const EditorFlowScene* scene()  const{ return _scene; }
     const QtNodes::FlowView* view() const { return _view; }
 
+    /// Keep the tree, without creating its nodes until they are needed.
+    void loadTreeLazily(const AbsBehaviorTree &tree);
+
+    /// False if the scene was not created yet (see loadTreeLazily()).
+    bool isMaterialized() const { return !_has_pending_tree; }
+
+    void materialize();
+
     void lockEditing(bool locked);
 
     void lockSubtreeEditing(QtNodes::Node& node, bool locked, bool change_style);
 
     void nodeReorder();
 
+    /// Lay out again only the subtree of subtree_root, after it was edited:
+    /// the rest of the tree moves only if it overlaps with it.
+    void nodeReorder(QtNodes::Node& subtree_root);
+
+    /// Lay out the tree again with the ports on the given side. A tree that is
+    /// not materialized is laid out when its scene is created.
+    /// Returns true if the nodes were moved.
+    bool setPortLayout(QtNodes::PortLayout layout);
+
     void saveSvgFile(const QString path);
 
     void zoomHomeView();
@@ -41,16 +60,44 @@ public:
 
     void clearScene();
 
+    /// Structure of the tree, available without creating the scene.
     AbsBehaviorTree loadedTree() const;
 
+    /// Node of the tree and index of its parent (-1 for the root).
+    struct IndexedNode
+    {
+        QtNodes::Node* node;
+        int parent_index;
+    };
+
+    /// Graphic nodes, with the same indexing of loadedTree().
+    /// Built lazily and invalidated only when the structure of the scene changes.
+    const std::vector<IndexedNode>& indexedNodes();
+
+    void invalidateIndexedNodes() { _indexed_nodes_valid = false; }
+
+    /// Changes whenever the scene is modified. Values are never reused, not even
+    /// by other containers: a snapshot tagged with it can be validated cheaply.
+    quint64 revision() const { return _revision; }
+
     void loadSceneFromTree(const AbsBehaviorTree &tree);
 
     void appendTreeToNode(QtNodes::Node& node, AbsBehaviorTree &subtree);
 
-    void loadFromJson(const QByteArray& data);
+    /// Accepts both the output of FlowScene::saveToBinary() and of saveToBinary().
+    void loadFromBinary(const QByteArray& data);
+
+    /// Same as FlowScene::saveToBinary(), but a tree that is not materialized
+    /// yet is saved as it is.
+    QByteArray saveToBinary() const;
 
     QtNodes::Node* substituteNode(QtNodes::Node* old_node, const QString& new_node_ID);
 
+    /// Same as substituteNode() for all the nodes with the model prev_ID, but
+    /// done on the tree that is not materialized yet (see loadTreeLazily()).
+    /// Returns false if there is no such tree.
+    bool substitutePendingModel(const QString& prev_ID, const NodeModel& new_model);
+
     void deleteSubTreeRecursively(QtNodes::Node& node);
 
     std::set<QtNodes::Node*> getSubtreeNodesRecursively(QtNodes::Node &root_node);
@@ -71,6 +118,10 @@ public slots:
 
     void onSmartRemove(QtNodes::Node* node);
 
+    /// To be called after changes that the scene does not notify, as moving nodes
+    /// with FlowScene::setNodePosition().
+    void markChanged();
+
 signals:
 
     void addNewModel( const NodeModel &new_model );
@@ -82,6 +133,10 @@ signals:
 
     void requestSubTreeCreate(AbsBehaviorTree tree, QString name);
 
+    /// The scene was created from the tree given to loadTreeLazily(). This is not
+    /// a change of the tree: it is emitted even when the signals are blocked.
+    void materialized();
+
 private:
     EditorFlowScene* _scene;
     QtNodes::FlowView*  _view;
@@ -100,6 +155,14 @@ private:
 
    bool _signal_was_blocked;
 
+   std::vector<IndexedNode> _indexed_nodes;
+   bool _indexed_nodes_valid;
+
+   quint64 _revision;
+
+   AbsBehaviorTree _pending_tree;
+   bool _has_pending_tree;
+   bool _editing_locked;
 };
 
 #endif // GRAPHIC_CONTAINER_H
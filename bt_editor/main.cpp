@@ -1,6 +1,7 @@
 #include <QCommandLineParser>
 #include <QApplication>
 #include <QDialog>
+#include <QStandardPaths>
 #include <nodes/NodeStyle>
 #include <nodes/FlowViewStyle>
 #include <nodes/ConnectionStyle>
@@ -144,15 +145,8 @@ main(int argc, char *argv[])
                 return 1;
             }
 
-            // Read file to xml
-            QString xml_text;
-            QTextStream in(&file);
-            while (!in.atEnd()) {
-                xml_text += in.readLine();
-            }
-
             // Show xml
-            win.loadFromXML( xml_text );
+            win.loadFromXML( QString::fromUtf8( file.readAll() ) );
         }
 
 
@@ -171,6 +165,12 @@ main(int argc, char *argv[])
         }
 
         win.show();
+
+        if ( mode == GraphicMode::EDITOR )
+        {
+            win.startAutosave( QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation) +
+                               "/autosave" );
+        }
         return app.exec();
     }
 }
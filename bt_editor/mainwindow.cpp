@@ -23,6 +23,7 @@
 #include <nodes/NodeStyle>
 #include <nodes/FlowView>
 #include <thread>
+#include <algorithm>
 
 #include "editor_flowscene.h"
 #include "utils.h"
@@ -41,6 +42,9 @@ using QtNodes::FlowScene;
 using QtNodes::NodeGraphicsObject;
 using QtNodes::NodeState;
 
+const size_t MainWindow::UNDO_MEMORY_BUDGET;
+const int MainWindow::AUTOSAVE_INTERVAL_MS;
+
 MainWindow::MainWindow(GraphicMode initial_mode,
                        const QString& monitor_address,
                        const QString& monitor_pub_port,
@@ -50,6 +54,7 @@ MainWindow::MainWindow(GraphicMode initial_mode,
     QMainWindow(parent),
     ui(new Ui::MainWindow),
     _current_mode(initial_mode),
+    _undo_stack_bytes(0),
     _current_layout(QtNodes::PortLayout::Vertical),
     _monitor_address(monitor_address),
     _monitor_publisher_port(monitor_pub_port),
@@ -223,10 +228,13 @@ MainWindow::MainWindow(GraphicMode initial_mode,
     connect( ui->tabWidget->tabBar(), &QTabBar::customContextMenuRequested,
             this, &MainWindow::onTabCustomContextMenuRequested);
 
+    _autosave_timer.setInterval( AUTOSAVE_INTERVAL_MS );
+    connect( &_autosave_timer, &QTimer::timeout, this, &MainWindow::onAutosave );
+
     createTab("BehaviorTree");
     onTabSetMainTree(0);
     onSceneChanged();
-    _current_state = saveCurrentState();
+    saveCurrentState();
 }
 
 
@@ -247,6 +255,8 @@ void MainWindow::closeEvent(QCloseEvent *event)
 
     settings.setValue("StartupDialog.Mode", toStr( _current_mode ) );
 
+    stopAutosave();
+
     QMainWindow::closeEvent(event);
 }
 
@@ -270,7 +280,10 @@ GraphicContainer* MainWindow::createTab(const QString &name)
     //--------------------------------
 
     connect( ti, &GraphicContainer::undoableChange,
-            this, &MainWindow::onPushUndo );
+            this, [this, ti]() { onTabUndoableChange(ti); } );
+
+    connect( ti, &GraphicContainer::materialized,
+            this, [this, ti]() { onTabMaterialized(ti); } );
 
     connect( ti, &GraphicContainer::undoableChange,
             this, &MainWindow::onSceneChanged );
@@ -297,32 +310,9 @@ MainWindow::~MainWindow()
 
 void MainWindow::loadFromXML(const QString& xml_text)
 {
-    QDomDocument document;
+    XmlProject project;
     try{
-        QString errorMsg;
-        int errorLine;
-        if( ! document.setContent(xml_text, &errorMsg, &errorLine ) )
-        {
-            throw std::runtime_error( tr("Error parsing XML (line %1): %2").arg(errorLine).arg(errorMsg).toStdString() );
-        }
-        //---------------
-        std::vector<QString> registered_ID;
-        for (const auto& it: _treenode_models)
-        {
-            registered_ID.push_back( it.first );
-        }
-        std::vector<QString> error_messages;
-        bool done = VerifyXML(document, registered_ID, error_messages );
-
-        if( !done )
-        {
-            QString merged_error;
-            for (const auto& err: error_messages)
-            {
-                merged_error += err + "\n";
-            }
-            throw std::runtime_error( merged_error.toStdString() );
-        }
+        project = ReadProjectFromXML( xml_text );
     }
     catch( std::runtime_error& err)
     {
@@ -335,18 +325,16 @@ void MainWindow::loadFromXML(const QString& xml_text)
     //---------------
     bool error = false;
     QString err_message;
-    auto saved_state = _current_state;
+    auto saved_state = lastSavedState();
     auto prev_tree_model = _treenode_models;
 
     try {
-        auto document_root = document.documentElement();
-
-        if( document_root.hasAttribute("main_tree_to_execute"))
+        if( !project.main_tree.isEmpty() )
         {
-            _main_tree = document_root.attribute("main_tree_to_execute");
+            _main_tree = project.main_tree;
         }
 
-        auto custom_models = ReadTreeNodesModel( document_root );
+        const auto& custom_models = project.models;
 
         for( const auto& model: custom_models)
         {
@@ -357,24 +345,36 @@ void MainWindow::loadFromXML(const QString& xml_text)
 
         onActionClearTriggered(false);
 
-        const QSignalBlocker blocker( currentTabInfo() );
+        if( project.has_root_tag )
+        {
+            QMessageBox::question(nullptr,
+                                  "Fix your file!",
+                                  "Please remove the node <Root> from your <BehaviorTree>",
+                                  QMessageBox::Ok );
+        }
 
-        for (auto bt_root = document_root.firstChildElement("BehaviorTree");
-             !bt_root.isNull();
-             bt_root = bt_root.nextSiblingElement("BehaviorTree"))
+        AssignTreeModels( project.trees, _treenode_models );
+
+        // Create the tabs first and select the main one: it is the only scene
+        // built right away, the others are created when their tab is opened.
+        std::vector<QString> tree_names;
+        for (const auto& xml_tree: project.trees)
         {
-            auto tree = BuildTreeFromXML( bt_root, _treenode_models );
             QString tree_name("BehaviorTree");
 
-            if( bt_root.hasAttribute("ID") )
+            if( !xml_tree.ID.isEmpty() )
             {
-                tree_name = bt_root.attribute("ID");
+                tree_name = xml_tree.ID;
                 if( _main_tree.isEmpty() )  // valid when there is only one
                 {
                     _main_tree = tree_name;
                 }
             }
-            onCreateAbsBehaviorTree(tree, tree_name);
+            if( !getTabByName(tree_name) )
+            {
+                createTab(tree_name);
+            }
+            tree_names.push_back( tree_name );
         }
 
         if( !_main_tree.isEmpty() )
@@ -391,6 +391,13 @@ void MainWindow::loadFromXML(const QString& xml_text)
             }
         }
 
+        const QSignalBlocker blocker( currentTabInfo() );
+
+        for (size_t i=0; i < project.trees.size(); i++)
+        {
+            onCreateAbsBehaviorTree(project.trees[i].tree, tree_names[i]);
+        }
+
         if( currentTabInfo() == nullptr)
         {
             createTab("BehaviorTree");
@@ -414,7 +421,7 @@ void MainWindow::loadFromXML(const QString& xml_text)
     if( error )
     {
         _treenode_models = prev_tree_model;
-        loadSavedStateFromJson( saved_state );
+        loadSavedState( saved_state );
         qDebug() << "R: Undo size: " << _undo_stack.size() << " Redo size: " << _redo_stack.size();
         QMessageBox::warning(this, tr("Exception!"),
                              tr("It was not possible to parse the file. Error:\n\n%1"). arg( err_message ),
@@ -450,57 +457,68 @@ void MainWindow::on_actionLoad_triggered()
     settings.setValue("MainWindow.lastLoadDirectory", directory_path);
     settings.sync();
 
-    QString xml_text;
-
-    QTextStream in(&file);
-    while (!in.atEnd()) {
-        xml_text += in.readLine();
-    }
-
-    loadFromXML(xml_text);
+    loadFromXML( QString::fromUtf8( file.readAll() ) );
 }
 
 QString MainWindow::saveToXML() const
 {
-    QDomDocument doc;
+    QString output_string;
+    QXmlStreamWriter stream(&output_string);
+
+    stream.setAutoFormatting(true);
+    stream.setAutoFormattingIndent(4);
 
-    const char* COMMENT_SEPARATOR = " ////////// ";
+    const QString COMMENT_SEPARATOR = " ////////// ";
 
-    QDomElement root = doc.createElement( "root" );
-    doc.appendChild( root );
+    stream.writeStartDocument();
+    stream.writeStartElement("root");
 
     if( _main_tree.isEmpty() == false)
     {
-        root.setAttribute("main_tree_to_execute", _main_tree.toStdString().c_str());
+        stream.writeAttribute("main_tree_to_execute", _main_tree);
     }
 
     for (auto& it: _tab_info)
     {
         auto& container = it.second;
-        auto  scene = container->scene();
 
-        auto abs_tree = BuildTreeFromScene(container->scene());
-        auto abs_root = abs_tree.rootNode();
-        if( abs_root->children_index.size() == 1 &&
-            abs_root->model.registration_ID == "Root"  )
+        stream.writeComment(COMMENT_SEPARATOR);
+        stream.writeStartElement("BehaviorTree");
+        stream.writeAttribute("ID", it.first);
+
+        if( container->isMaterialized() )
         {
-            // move to the child of ROOT
-            abs_root = abs_tree.node( abs_root->children_index.front() );
+            const auto& scene = *container->scene();
+            const QtNodes::Node* root_node = findRoot( scene );
+            if( root_node )
+            {
+                auto root_children = getChildren( scene, *root_node, false );
+                if( root_children.size() == 1 &&
+                    root_node->nodeDataModel()->name() == "Root" )
+                {
+                    // move to the child of ROOT
+                    root_node = root_children.front();
+                }
+                RecursivelyCreateXml(stream, scene, root_node );
+            }
         }
-
-        QtNodes::Node* root_node = abs_root->graphic_node;
-
-        root.appendChild( doc.createComment(COMMENT_SEPARATOR) );
-        QDomElement root_element = doc.createElement("BehaviorTree");
-
-        root_element.setAttribute("ID", it.first.toStdString().c_str());
-        root.appendChild(root_element);
-
-        RecursivelyCreateXml(*scene, doc, root_element, root_node );
+        else{
+            // tabs never opened are saved without creating their scene
+            auto abs_tree = container->loadedTree();
+            auto abs_root = abs_tree.rootNode();
+            if( abs_root->children_index.size() == 1 &&
+                abs_root->model.registration_ID == "Root"  )
+            {
+                // move to the child of ROOT
+                abs_root = abs_tree.node( abs_root->children_index.front() );
+            }
+            RecursivelyCreateXml(stream, abs_tree, abs_root );
+        }
+        stream.writeEndElement();
     }
-    root.appendChild( doc.createComment(COMMENT_SEPARATOR) );
+    stream.writeComment(COMMENT_SEPARATOR);
 
-    QDomElement root_models = doc.createElement("TreeNodesModel");
+    stream.writeStartElement("TreeNodesModel");
 
     for(const auto& tree_it: _treenode_models)
     {
@@ -512,125 +530,22 @@ QString MainWindow::saveToXML() const
             continue;
         }
 
-        QDomElement node = doc.createElement( QString::fromStdString(toStr(model.type)) );
-
-        if( !node.isNull() )
-        {
-            node.setAttribute("ID", ID);
-
-            for(const auto& port_it: model.ports)
-            {
-                const auto& port_name = port_it.first;
-                const auto& port = port_it.second;
-
-                QDomElement port_element = writePortModel(port_name, port, doc);
-                node.appendChild( port_element );
-            }
-        }
-        root_models.appendChild(node);
-    }
-    root.appendChild(root_models);
-    root.appendChild( doc.createComment(COMMENT_SEPARATOR) );
-
-    return xmlDocumentToString(doc);
-}
-
-QString MainWindow::xmlDocumentToString(const QDomDocument &document) const
-{
-  QString output_string;
-
-  QXmlStreamWriter stream(&output_string);
-
-  stream.setAutoFormatting(true);
-  stream.setAutoFormattingIndent(4);
-
-  stream.writeStartDocument();
-
-  auto root_element = document.documentElement();
-
-  stream.writeStartElement(root_element.tagName());
-
-  streamElementAttributes(stream, root_element);
-
-  auto next_node = root_element.firstChild();
-
-  while ( !next_node.isNull() )
-  {
-    recursivelySaveNodeCanonically(stream, next_node);
-
-    if ( stream.hasError() )
-    {
-        break;
-    }
-    next_node = next_node.nextSibling();
-  }
-
-  stream.writeEndElement();
-  stream.writeEndDocument();
-
-  return output_string;
-}
-
-void MainWindow::streamElementAttributes(QXmlStreamWriter &stream, const QDomElement &element) const
-{
-    if (element.hasAttributes())
-    {
-        QMap<QString, QString> attributes;
-        const QDomNamedNodeMap attributes_map = element.attributes();
-
-        for (int i = 0; i < attributes_map.count(); ++i)
-        {
-           auto attribute = attributes_map.item(i);
-            attributes.insert(attribute.nodeName(), attribute.nodeValue());
-        }
+        stream.writeStartElement( QString::fromStdString(toStr(model.type)) );
+        stream.writeAttribute("ID", ID);
 
-        auto i = attributes.constBegin();
-        while (i != attributes.constEnd())
+        for(const auto& port_it: model.ports)
         {
-            stream.writeAttribute(i.key(), i.value());
-            ++i;
+            writePortModel(stream, port_it.first, port_it.second);
         }
+        stream.writeEndElement();
     }
-}
-
-void MainWindow::recursivelySaveNodeCanonically(QXmlStreamWriter &stream, const QDomNode &parent_node) const
-{
-  if ( stream.hasError() )
-  {
-    return;
-  }
-
-  if ( parent_node.isElement() )
-  {
-    const QDomElement parent_element = parent_node.toElement();
+    stream.writeEndElement();
+    stream.writeComment(COMMENT_SEPARATOR);
 
-    if ( !parent_element.isNull() )
-    {
-        stream.writeStartElement(parent_element.tagName());
-
-        streamElementAttributes(stream, parent_element);
+    stream.writeEndElement();
+    stream.writeEndDocument();
 
-        if (parent_element.hasChildNodes())
-        {
-            auto child = parent_element.firstChild();
-            while ( !child.isNull() )
-            {
-                recursivelySaveNodeCanonically(stream, child);
-                child = child.nextSibling();
-            }
-        }
-
-        stream.writeEndElement();
-    }
-  }
-  else if (parent_node.isComment())
-  {
-    stream.writeComment(parent_node.nodeValue());
-  }
-  else if (parent_node.isText())
-  {
-    stream.writeCharacters(parent_node.nodeValue());
-  }
+    return output_string;
 }
 
 void MainWindow::on_actionSave_triggered()
@@ -795,46 +710,257 @@ void MainWindow::on_splitter_splitterMoved(int , int )
 
 MainWindow::SavedState MainWindow::saveCurrentState()
 {
-    SavedState saved;
     int index = ui->tabWidget->currentIndex();
-    saved.main_tree = _main_tree;
-    saved.current_tab_name = ui->tabWidget->tabText(index);
-    auto current_view = getTabByName( saved.current_tab_name )->view();
-    saved.view_transform = current_view->transform();
-    saved.view_area = current_view->sceneRect();
+    _current_state.main_tree = _main_tree;
+    _current_state.current_tab_name = ui->tabWidget->tabText(index);
+    auto current_view = getTabByName( _current_state.current_tab_name )->view();
+    _current_state.view_transform = current_view->transform();
+    _current_state.view_area = current_view->sceneRect();
 
+    std::map<QString, TabSnapshot> snapshots;
     for (auto& it: _tab_info)
     {
-        saved.json_states[it.first] = it.second->scene()->saveToMemory();
+        GraphicContainer* container = it.second;
+        TabSnapshot& snapshot = snapshots[it.first];
+
+        auto prev_it = _tab_snapshots.find( it.first );
+        if( prev_it != _tab_snapshots.end() )
+        {
+            if( prev_it->second.revision == container->revision() )
+            {
+                snapshot = std::move( prev_it->second );
+                continue;
+            }
+        }
+        if( !container->isMaterialized() )
+        {
+            // the scene is empty until the tab is opened: see onTabMaterialized()
+            snapshot.binary = container->saveToBinary();
+            if( prev_it != _tab_snapshots.end() && prev_it->second.binary == snapshot.binary )
+            {
+                snapshot.binary = prev_it->second.binary;
+            }
+        }
+        else{
+            snapshot.scene = SceneSnapshot( *container->scene() );
+            if( prev_it != _tab_snapshots.end() && snapshot.scene == prev_it->second.scene )
+            {
+                // keep sharing the serialized data
+                snapshot.binary = prev_it->second.binary;
+            }
+        }
+        snapshot.revision = container->revision();
+    }
+    _tab_snapshots = std::move(snapshots);
+    return lastSavedState();
+}
+
+MainWindow::SavedState MainWindow::lastSavedState()
+{
+    SavedState saved = _current_state;
+    for (auto& it: _tab_snapshots)
+    {
+        TabSnapshot& snapshot = it.second;
+        if( snapshot.binary.isEmpty() )
+        {
+            snapshot.binary = snapshot.scene.toBinary();
+        }
+        saved.scene_states[it.first] = snapshot.binary;
     }
     return saved;
 }
 
-void MainWindow::onPushUndo()
+bool MainWindow::tabsMatchSnapshots() const
 {
-    SavedState saved = saveCurrentState();
+    if( _tab_info.size() != _tab_snapshots.size() )
+    {
+        return false;
+    }
+    for (auto& it: _tab_info)
+    {
+        if( _tab_snapshots.count( it.first ) == 0 )
+        {
+            return false;
+        }
+    }
+    return true;
+}
 
-    if( _undo_stack.empty() || ( saved != _current_state &&  _undo_stack.back() != _current_state) )
+void MainWindow::pushUndoEntry(UndoEntry&& entry)
+{
+    if( entry.tab_name.isEmpty() )
     {
-        _undo_stack.push_back( std::move(_current_state) );
-        _redo_stack.clear();
+        // identical tab states share their memory with the previous full state
+        auto prev_it = std::find_if( _undo_stack.rbegin(), _undo_stack.rend(),
+                                     [](const UndoEntry& prev) { return prev.tab_name.isEmpty(); } );
+        if( prev_it != _undo_stack.rend() )
+        {
+            const auto& prev_states = prev_it->state.scene_states;
+            for (auto& it: entry.state.scene_states)
+            {
+                auto prev_state = prev_states.find( it.first );
+                if( prev_state != prev_states.end() && prev_state->second == it.second )
+                {
+                    it.second = prev_state->second;
+                }
+            }
+        }
     }
-    _current_state = saved;
 
+    _redo_stack.clear();
+    _undo_stack_bytes += entry.byteSize();
+    _undo_stack.push_back( std::move(entry) );
+
+    while( _undo_stack.size() > 1 && _undo_stack_bytes > UNDO_MEMORY_BUDGET )
+    {
+        _undo_stack_bytes -= _undo_stack.front().byteSize();
+        _undo_stack.pop_front();
+    }
     //qDebug() << "P: Undo size: " << _undo_stack.size() << " Redo size: " << _redo_stack.size();
 }
 
+void MainWindow::onPushUndo()
+{
+    flushUndoableChanges();
+
+    if( _tab_snapshots.empty() ) // nothing to go back to
+    {
+        saveCurrentState();
+        return;
+    }
+
+    UndoEntry entry;
+    entry.state = lastSavedState();
+    if( saveCurrentState() != entry.state )
+    {
+        pushUndoEntry( std::move(entry) );
+    }
+}
+
+void MainWindow::onTabUndoableChange(GraphicContainer *container)
+{
+    // Dragging or deleting nodes notifies many changes in a row:
+    // record them once, when the control goes back to the event loop.
+    if( _pending_undo_tabs.empty() )
+    {
+        QTimer::singleShot(0, this, &MainWindow::flushUndoableChanges);
+    }
+    if( std::find(_pending_undo_tabs.begin(), _pending_undo_tabs.end(), container) ==
+        _pending_undo_tabs.end() )
+    {
+        _pending_undo_tabs.push_back( container );
+    }
+}
+
+void MainWindow::onTabMaterialized(GraphicContainer *container)
+{
+    // Creating the nodes of a tab is not an undoable change: the scene becomes
+    // the reference for the next changes, while the saved state of the tab,
+    // if any, is still valid.
+    for (auto& it: _tab_info)
+    {
+        auto snapshot_it = _tab_snapshots.find( it.first );
+        if( it.second == container && snapshot_it != _tab_snapshots.end() )
+        {
+            snapshot_it->second.scene = SceneSnapshot( *container->scene() );
+            snapshot_it->second.revision = container->revision();
+        }
+    }
+}
+
+void MainWindow::flushUndoableChanges()
+{
+    std::vector<GraphicContainer*> pending;
+    std::swap( pending, _pending_undo_tabs );
+
+    for (auto container: pending)
+    {
+        // the tab might have been closed in the meantime
+        auto tab_it = std::find_if( _tab_info.begin(), _tab_info.end(),
+                                    [container](const std::pair<const QString, GraphicContainer*>& it)
+                                    { return it.second == container; } );
+        if( tab_it == _tab_info.end() )
+        {
+            continue;
+        }
+        if( !tabsMatchSnapshots() )
+        {
+            // tabs were created or removed: this is not a change of a single tab
+            onPushUndo();
+            return;
+        }
+
+        TabSnapshot& prev_snapshot = _tab_snapshots[tab_it->first];
+        if( prev_snapshot.revision == container->revision() )
+        {
+            continue;
+        }
+        SceneSnapshot snapshot( *container->scene() );
+        prev_snapshot.revision = container->revision();
+
+        UndoEntry entry;
+        entry.diff = SceneDiff( prev_snapshot.scene, snapshot );
+        if( entry.diff.empty() )
+        {
+            continue;
+        }
+        entry.tab_name = tab_it->first;
+        prev_snapshot.scene = std::move(snapshot);
+        prev_snapshot.binary.clear();
+        pushUndoEntry( std::move(entry) );
+    }
+}
+
+void MainWindow::applyUndoEntry(UndoEntry &entry, bool forward)
+{
+    if( entry.tab_name.isEmpty() )
+    {
+        SavedState current_state = lastSavedState();
+        loadSavedState( entry.state );
+        saveCurrentState();
+        entry.state = std::move(current_state);
+        return;
+    }
+
+    auto container = getTabByName( entry.tab_name );
+    if( !container )
+    {
+        return;
+    }
+    {
+        const QSignalBlocker blocker( container );
+        entry.diff.apply( *container->scene(), forward );
+    }
+    TabSnapshot& snapshot = _tab_snapshots[entry.tab_name];
+    entry.diff.apply( snapshot.scene, forward );
+    snapshot.revision = container->revision();
+    snapshot.binary.clear();
+
+    for (int i=0; i< ui->tabWidget->count(); i++)
+    {
+        if( ui->tabWidget->tabText( i ) == entry.tab_name )
+        {
+            ui->tabWidget->setCurrentIndex(i);
+            break;
+        }
+    }
+    onSceneChanged();
+}
+
 void MainWindow::onUndoInvoked()
 {
     if ( _current_mode != GraphicMode::EDITOR ) return; //locked
 
+    flushUndoableChanges();
+
     if( _undo_stack.size() > 0)
     {
-        _redo_stack.push_back( std::move(_current_state) );
-        _current_state = _undo_stack.back();
+        UndoEntry entry = std::move( _undo_stack.back() );
         _undo_stack.pop_back();
+        _undo_stack_bytes -= entry.byteSize();
 
-        loadSavedStateFromJson(_current_state);
+        applyUndoEntry( entry, false );
+        _redo_stack.push_back( std::move(entry) );
 
         // qDebug() << "U: Undo size: " << _undo_stack.size() << " Redo size: " << _redo_stack.size();
     }
@@ -844,19 +970,22 @@ void MainWindow::onRedoInvoked()
 {
     if ( _current_mode != GraphicMode::EDITOR ) return; //locked
 
+    flushUndoableChanges();
+
     if( _redo_stack.size() > 0)
     {
-        _undo_stack.push_back( _current_state );
-        _current_state = std::move( _redo_stack.back() );
+        UndoEntry entry = std::move( _redo_stack.back() );
         _redo_stack.pop_back();
 
-        loadSavedStateFromJson(_current_state);
+        applyUndoEntry( entry, true );
+        _undo_stack_bytes += entry.byteSize();
+        _undo_stack.push_back( std::move(entry) );
 
         // qDebug() << "R: Undo size: " << _undo_stack.size() << " Redo size: " << _redo_stack.size();
     }
 }
 
-void MainWindow::loadSavedStateFromJson(SavedState saved_state)
+void MainWindow::loadSavedState(SavedState saved_state)
 {
     // TODO crash if the name of the container (tab) changed
     for (auto& it: _tab_info)
@@ -869,17 +998,18 @@ void MainWindow::loadSavedStateFromJson(SavedState saved_state)
 
     _main_tree = saved_state.main_tree;
 
-    for(const auto& it: saved_state.json_states)
+    for(const auto& it: saved_state.scene_states)
     {
         QString tab_name = it.first;
         _tab_info.insert( {tab_name, createTab(tab_name)} );
     }
-    for(const auto& it: saved_state.json_states)
+    for(const auto& it: saved_state.scene_states)
     {
         QString name = it.first;
         auto container = getTabByName(name);
-        container->loadFromJson( it.second );
+        container->loadFromBinary( it.second );
         container->view()->setTransform( saved_state.view_transform );
+        container->view()->updateLevelOfDetail();
         container->view()->setSceneRect( saved_state.view_area );
     }
 
@@ -902,12 +1032,114 @@ void MainWindow::loadSavedStateFromJson(SavedState saved_state)
     onSceneChanged();
 }
 
+bool MainWindow::startAutosave(const QString &directory)
+{
+    if( !_autosave.start( directory ) )
+    {
+        qDebug() << "Autosave disabled: can not lock " << directory;
+        return false;
+    }
+
+    AutosaveState state;
+    if( AutosaveJournal::recover( directory, state ) )
+    {
+        int ret = QMessageBox::question(this, "Recover unsaved trees?",
+                                        "Groot was not closed properly.\n"
+                                        "Do you want to recover the trees that were not saved?",
+                                        QMessageBox::Yes | QMessageBox::No);
+        if( ret == QMessageBox::Yes )
+        {
+            loadAutosaveState( state );
+        }
+    }
+
+    onAutosave();
+    _autosave_timer.start();
+    return true;
+}
+
+void MainWindow::stopAutosave(bool discard)
+{
+    _autosave_timer.stop();
+    if( discard )
+    {
+        _autosave.discard();
+    }
+    else{
+        _autosave.stop();
+    }
+}
+
+bool MainWindow::recoverAutosave(const QString &directory)
+{
+    AutosaveState state;
+    if( !AutosaveJournal::recover( directory, state ) )
+    {
+        return false;
+    }
+    loadAutosaveState( state );
+    return true;
+}
+
+void MainWindow::loadAutosaveState(const AutosaveState &state)
+{
+    for(const auto& it: state.models)
+    {
+        auto model_it = _treenode_models.find( it.first );
+        if( model_it == _treenode_models.end() )
+        {
+            onAddToModelRegistry( it.second );
+        }
+        else if( model_it->second != it.second )
+        {
+            _treenode_models.erase( model_it );
+            onAddToModelRegistry( it.second );
+        }
+    }
+
+    SavedState saved_state;
+    saved_state.main_tree = state.main_tree;
+    saved_state.current_tab_name = state.current_tab_name;
+    saved_state.scene_states = state.scene_states;
+    loadSavedState( saved_state );
+
+    currentTabInfo()->zoomHomeView();
+    onPushUndo();
+}
+
+void MainWindow::onAutosave()
+{
+    if( !_autosave.isRunning() )
+    {
+        return;
+    }
+    // Only the undo state is used: the tabs changed since the previous
+    // autosave are already serialized, the others are shared.
+    flushUndoableChanges();
+    SavedState saved_state = lastSavedState();
+
+    AutosaveState state;
+    state.main_tree = _main_tree;
+    state.current_tab_name = saved_state.current_tab_name;
+    state.scene_states = std::move( saved_state.scene_states );
+    for(const auto& it: _treenode_models)
+    {
+        if( BuiltinNodeModels().count( it.first ) == 0 )
+        {
+            state.models.insert( it );
+        }
+    }
+    _autosave.submit( state );
+}
+
 void MainWindow::onConnectionUpdate(bool connected)
 {
     if(connected)
     {
         ui->toolButtonConnect->setStyleSheet("background-color: rgb(50, 150, 0); color:white");
         ui->toolButtonConnect->setText("Disconnect");
+        // nodes stay locked while the remote tree is monitored
+        lockEditing(true);
     }
     else{
         ui->toolButtonConnect->setStyleSheet(
@@ -916,6 +1148,7 @@ void MainWindow::onConnectionUpdate(bool connected)
             "QToolButton:pressed{ background-color: rgb(50, 150, 0) }"
             "QToolButton:disabled{color:gray; background-color: rgb(50, 50, 50) }");
         ui->toolButtonConnect->setText("Connect");
+        lockEditing( _current_mode != GraphicMode::EDITOR );
     }
 }
 
@@ -971,6 +1204,21 @@ void MainWindow::onDestroySubTree(const QString &ID)
             continue;
         }
         auto container = it.second;
+        if( !container->isMaterialized() )
+        {
+            // create the scene only if there is something to expand
+            const auto pending_tree = container->loadedTree();
+            bool found = false;
+            for( const auto& abs_node: pending_tree.nodes())
+            {
+                found |= ( abs_node.model.type == NodeType::SUBTREE &&
+                           abs_node.instance_name == ID );
+            }
+            if( !found )
+            {
+                continue;
+            }
+        }
         auto tree = BuildTreeFromScene(container->scene());
         for( const auto& abs_node: tree.nodes())
         {
@@ -1015,26 +1263,36 @@ void MainWindow::onDestroySubTree(const QString &ID)
 
 void MainWindow::onModelRemoveRequested(QString ID)
 {
-    BehaviorTreeDataModel* node_found = nullptr;
+    bool node_found = false;
     QString tab_containing_node;
 
     for (auto& it: _tab_info)
     {
         auto container = it.second;
-        for(const auto& node_it: container->scene()->nodes() )
+        if( !container->isMaterialized() )
         {
-            QtNodes::Node* graphic_node = node_it.second.get();
-            auto bt_node = dynamic_cast<BehaviorTreeDataModel*>( graphic_node->nodeDataModel() );
-
-            if( bt_node->model().registration_ID == ID )
+            // do not create the scene of the tabs that were not opened
+            for(const auto& abs_node: container->loadedTree().nodes() )
             {
-                node_found = bt_node;
-                tab_containing_node = it.first;
-                break;
+                node_found |= ( abs_node.model.registration_ID == ID );
             }
         }
-        if( node_found != nullptr )
+        else{
+            for(const auto& node_it: container->scene()->nodes() )
+            {
+                QtNodes::Node* graphic_node = node_it.second.get();
+                auto bt_node = dynamic_cast<BehaviorTreeDataModel*>( graphic_node->nodeDataModel() );
+
+                if( bt_node->model().registration_ID == ID )
+                {
+                    node_found = true;
+                    break;
+                }
+            }
+        }
+        if( node_found )
         {
+            tab_containing_node = it.first;
             break;
         }
     }
@@ -1047,7 +1305,7 @@ void MainWindow::onModelRemoveRequested(QString ID)
 
     NodeType node_type = _treenode_models.at(ID).type;
 
-    if( node_found && node_type != NodeType::SUBTREE )
+    if( node_type != NodeType::SUBTREE )
     {
         QMessageBox::warning(this, "Can't remove this Model",
                              QString( "You are using this model in the Tree called [%1].\n"
@@ -1058,7 +1316,7 @@ void MainWindow::onModelRemoveRequested(QString ID)
     else
     {
         int ret = QMessageBox::Cancel;
-        if( node_found->model().type != NodeType::SUBTREE )
+        if( node_type != NodeType::SUBTREE )
         {
             ret = QMessageBox::warning(this,"Delete TreeNode Model?",
                                        "Are you sure? This action can't be undone.",
@@ -1110,7 +1368,7 @@ QtNodes::Node* MainWindow::subTreeExpand(GraphicContainer &container,
             return &node;
         }
 
-        auto abs_subtree = BuildTreeFromScene( subtree_container->scene() );
+        auto abs_subtree = subtree_container->loadedTree();
 
         subtree_model->setExpanded(true);
         node.nodeState().getEntries(PortType::Out).resize(1);
@@ -1119,7 +1377,7 @@ QtNodes::Node* MainWindow::subTreeExpand(GraphicContainer &container,
 
         if( abs_subtree.nodes().size() > 1 )
         {
-            container.nodeReorder();
+            container.nodeReorder( node );
         }
 
         return &node;
@@ -1149,7 +1407,7 @@ QtNodes::Node* MainWindow::subTreeExpand(GraphicContainer &container,
         container.lockSubtreeEditing( node, false, is_editor_mode );
         if( need_reorder )
         {
-            container.nodeReorder();
+            container.nodeReorder( node );
         }
 
         return &node;
@@ -1166,11 +1424,11 @@ QtNodes::Node* MainWindow::subTreeExpand(GraphicContainer &container,
         QtNodes::Node* child_node = conn_out.begin()->second->getNode( PortType::In );
 
         auto subtree_container = getTabByName(subtree_name);
-        auto subtree = BuildTreeFromScene( subtree_container->scene() );
+        auto subtree = subtree_container->loadedTree();
 
         container.deleteSubTreeRecursively( *child_node );
         container.appendTreeToNode( node, subtree );
-        container.nodeReorder();
+        container.nodeReorder( node );
         container.lockSubtreeEditing( node, true, is_editor_mode );
 
         return &node;
@@ -1198,8 +1456,10 @@ void MainWindow::clearUndoStacks()
 {
     _undo_stack.clear();
     _redo_stack.clear();
+    _undo_stack_bytes = 0;
+    _pending_undo_tabs.clear();
     onSceneChanged();
-    onPushUndo();
+    saveCurrentState();
 }
 
 void MainWindow::onCreateAbsBehaviorTree(const AbsBehaviorTree &tree,
@@ -1211,9 +1471,16 @@ void MainWindow::onCreateAbsBehaviorTree(const AbsBehaviorTree &tree,
     {
         container = createTab(bt_name);
     }
-    const QSignalBlocker blocker( container );
-    container->loadSceneFromTree( tree );
-    container->nodeReorder();
+    if( container == currentTabInfo() )
+    {
+        const QSignalBlocker blocker( container );
+        container->loadSceneFromTree( tree );
+        container->nodeReorder();
+    }
+    else{
+        // created when the tab is opened
+        container->loadTreeLazily( tree );
+    }
 
     if( secondary_tabs ){
       for(const auto& node: tree.nodes())
@@ -1230,6 +1497,7 @@ void MainWindow::onCreateAbsBehaviorTree(const AbsBehaviorTree &tree,
 
 void MainWindow::on_actionClear_triggered()
 {
+    _main_tree.clear();
     onActionClearTriggered(true);
     clearTreeModels();
     clearUndoStacks();
@@ -1237,9 +1505,16 @@ void MainWindow::on_actionClear_triggered()
 
 void MainWindow::onTreeNodeEdited(QString prev_ID, QString new_ID)
 {
+    auto model_it = _treenode_models.find( new_ID );
+
     for (auto& it: _tab_info)
     {
         auto container = it.second;
+        if( !container->isMaterialized() && model_it != _treenode_models.end() )
+        {
+            container->substitutePendingModel( prev_ID, model_it->second );
+            continue;
+        }
         std::vector<QtNodes::Node*> nodes_to_rename;
 
         for(const auto& node_it: container->scene()->nodes() )
@@ -1383,14 +1658,8 @@ void MainWindow::refreshNodesLayout(QtNodes::PortLayout new_layout)
         const QSignalBlocker blocker( currentTabInfo() );
         for(auto& tab: _tab_info)
         {
-            auto scene = tab.second->scene();
-            if( scene->layout() != new_layout )
-            {
-                auto abstract_tree = BuildTreeFromScene( scene );
-                scene->setLayout( new_layout );
-                NodeReorder( *scene, abstract_tree );
-                refreshed = true;
-            }
+            // the tabs that were not opened yet are laid out when they are
+            refreshed |= tab.second->setPortLayout( new_layout );
         }
         on_toolButtonCenterView_pressed();
     }
@@ -1533,18 +1802,28 @@ void MainWindow::on_tabWidget_currentChanged(int index)
     }
 }
 
+size_t MainWindow::UndoEntry::byteSize() const
+{
+    size_t size = sizeof(UndoEntry) + diff.byteSize();
+    for(auto& it: state.scene_states)
+    {
+        size += it.second.size();
+    }
+    return size;
+}
+
 bool MainWindow::SavedState::operator ==(const MainWindow::SavedState &other) const
 {
     if( current_tab_name != other.current_tab_name ||
-        json_states.size() != other.json_states.size())
+        scene_states.size() != other.scene_states.size())
     {
         return false;
     }
-    for(auto& it: json_states  )
+    for(auto& it: scene_states  )
     {
-        auto other_it = other.json_states.find(it.first);
-        if( other_it == other.json_states.end() ||
-            it.second != other_it->second)
+        auto other_it = other.scene_states.find(it.first);
+        if( other_it == other.scene_states.end() ||
+            (it.second.constData() != other_it->second.constData() && it.second != other_it->second) )
         {
             return false;
         }
@@ -1557,13 +1836,13 @@ bool MainWindow::SavedState::operator ==(const MainWindow::SavedState &other) co
     return true;
 }
 
-void MainWindow::resetTreeStyle(AbsBehaviorTree &tree){
+void MainWindow::resetTreeStyle(const std::vector<GraphicContainer::IndexedNode>& nodes){
     //printf("resetTreeStyle\n");
     QtNodes::NodeStyle  node_style;
     QtNodes::ConnectionStyle conn_style;
 
-    for(auto abs_node: tree.nodes()){
-        auto gui_node = abs_node.graphic_node;
+    for(const auto& indexed_node: nodes){
+        auto gui_node = indexed_node.node;
 
         gui_node->nodeDataModel()->setNodeStyle( node_style );
         gui_node->nodeGraphicsObject().update();
@@ -1581,9 +1860,14 @@ void MainWindow::resetTreeStyle(AbsBehaviorTree &tree){
 void MainWindow::onChangeNodesStatus(const QString& bt_name,
                                      const std::vector<std::pair<int, NodeStatus> > &node_status)
 {
-    auto tree = BuildTreeFromScene( getTabByName(bt_name)->scene() );
+    auto container = getTabByName(bt_name);
+    if( !container )
+    {
+        return;
+    }
+    const auto& nodes = container->indexedNodes();
 
-    std::vector<NodeStatus> vec_last_status(tree.nodesCount());
+    std::vector<NodeStatus> vec_last_status(nodes.size());
 
     // printf("---\n");
 
@@ -1591,14 +1875,17 @@ void MainWindow::onChangeNodesStatus(const QString& bt_name,
     {
         const int index = it.first;
         const NodeStatus status = it.second;
-        auto& abs_node = tree.nodes().at(index);
+        if( index < 0 || size_t(index) >= nodes.size() )
+        {
+            continue;
+        }
 
-        // printf("%3d: %d, %s\n", index, (int)it.second, abs_node.instance_name.toStdString().c_str());
+        // printf("%3d: %d\n", index, (int)it.second);
 
         if(index == 1 && it.second == NodeStatus::RUNNING)
-            resetTreeStyle(tree);
+            resetTreeStyle(nodes);
 
-        auto gui_node = abs_node.graphic_node;
+        auto gui_node = nodes[index].node;
         auto style = getStyleFromStatus( status, vec_last_status[index] );
         gui_node->nodeDataModel()->setNodeStyle( style.first );
         gui_node->nodeGraphicsObject().update();
@@ -1615,10 +1902,11 @@ void MainWindow::onChangeNodesStatus(const QString& bt_name,
 
         // Propagate token color updates up the ancestor chain, so any collapsed
         // ancestor can update its nested token for this node
-        for (auto parent_node = GetParentNode(gui_node);
-             parent_node != nullptr;
-             parent_node = GetParentNode(parent_node))
+        for (int parent_index = nodes[index].parent_index;
+             parent_index >= 0;
+             parent_index = nodes[parent_index].parent_index)
         {
+            auto parent_node = nodes[parent_index].node;
             if (auto parent_model = dynamic_cast<BehaviorTreeDataModel*>(parent_node->nodeDataModel()))
             {
                 parent_model->updateChildTokenStatus(*gui_node, status);
@@ -14,6 +14,8 @@
 #include <nodes/DataModelRegistry>
 
 #include "graphic_container.h"
+#include "scene_diff.h"
+#include "autosave_journal.h"
 #include "XML_utilities.hpp"
 #include "sidepanel_editor.h"
 #include "sidepanel_replay.h"
@@ -63,10 +65,21 @@ public:
 
     const NodeModels &registeredModels() const;
 
-    void resetTreeStyle(AbsBehaviorTree &tree);
+    void resetTreeStyle(const std::vector<GraphicContainer::IndexedNode>& nodes);
 
     GraphicMode getGraphicMode(void) const;
 
+    /// Save the trees periodically into directory, to recover them if Groot crashes.
+    /// If a previous instance left something to recover there, the user is asked
+    /// whether to load it. Returns false if the directory is used by another instance.
+    bool startAutosave(const QString& directory);
+
+    /// The files are removed, unless discard is false.
+    void stopAutosave(bool discard = true);
+
+    /// Load the trees saved into directory by autosave.
+    bool recoverAutosave(const QString& directory);
+
 public slots:
 
     void onAutoArrange();
@@ -77,10 +90,16 @@ public slots:
 
     void onPushUndo();
 
+    void onTabUndoableChange(GraphicContainer* container);
+
+    void onTabMaterialized(GraphicContainer* container);
+
     void onUndoInvoked();
 
     void onRedoInvoked();
 
+    void onAutosave();
+
     void onConnectionUpdate(bool connected);
 
     void onRequestSubTreeExpand(GraphicContainer& container,
@@ -164,24 +183,57 @@ private:
 
     void refreshExpandedSubtrees();
 
-    void streamElementAttributes(QXmlStreamWriter &stream, const QDomElement &element) const;
-
-    QString xmlDocumentToString(const QDomDocument &document) const;
-
-    void recursivelySaveNodeCanonically(QXmlStreamWriter &stream, const QDomNode &parent_node) const;
-
     struct SavedState
     {
         QString main_tree;
         QString current_tab_name;
         QTransform view_transform;
         QRectF view_area;
-        std::map<QString, QByteArray> json_states;
+        std::map<QString, QByteArray> scene_states; // FlowScene::saveToBinary() of each tab
         bool operator ==( const SavedState& other) const;
         bool operator !=( const SavedState& other) const { return !( *this == other); }
     };
 
-    void loadSavedStateFromJson(SavedState state);
+    /// One step of the undo/redo history. A change confined to one tab is stored
+    /// as the SceneDiff of that tab; anything else (files loaded, tabs created,
+    /// layout changed) as the whole SavedState to go back to.
+    struct UndoEntry
+    {
+        QString tab_name;   // empty if state must be used
+        SceneDiff diff;
+        SavedState state;
+        size_t byteSize() const;
+    };
+
+    /// Content of a tab when the last undo step was recorded.
+    struct TabSnapshot
+    {
+        TabSnapshot(): revision(0) {}
+        SceneSnapshot scene;
+        quint64 revision;   // GraphicContainer::revision() when scene was taken
+        QByteArray binary;  // GraphicContainer::saveToBinary(), empty until needed
+    };
+
+    /// Memory that the undo stack may use before the oldest steps are discarded.
+    /// Tab states shared by several steps are counted once per step.
+    static const size_t UNDO_MEMORY_BUDGET = 64 * 1024 * 1024;
+
+    void loadSavedState(SavedState state);
+
+    void loadAutosaveState(const AutosaveState& state);
+
+    /// Maximum time between a change and its autosave.
+    static const int AUTOSAVE_INTERVAL_MS = 1000;
+
+    void pushUndoEntry(UndoEntry&& entry);
+
+    /// Apply an entry taken from one of the stacks and turn it into its inverse.
+    void applyUndoEntry(UndoEntry& entry, bool forward);
+
+    /// Record the changes notified by the tabs since the last call.
+    void flushUndoableChanges();
+
+    bool tabsMatchSnapshots() const;
 
     QtNodes::Node *subTreeExpand(GraphicContainer& container,
                        QtNodes::Node &node,
@@ -197,13 +249,22 @@ private:
 
     std::mutex _mutex;
 
-    std::deque<SavedState> _undo_stack;
-    std::deque<SavedState> _redo_stack;
+    std::deque<UndoEntry> _undo_stack;
+    std::deque<UndoEntry> _redo_stack;
+    size_t _undo_stack_bytes;
+
+    // Main tree, current tab and view when the last undo step was recorded.
+    // scene_states is not used: the content of the tabs is in _tab_snapshots.
     SavedState _current_state;
+    std::map<QString, TabSnapshot> _tab_snapshots;
+    std::vector<GraphicContainer*> _pending_undo_tabs;
     QtNodes::PortLayout _current_layout;
 
     NodeModels _treenode_models;
 
+    AutosaveJournal _autosave;
+    QTimer _autosave_timer;
+
     QString _main_tree;
 
     SidepanelEditor* _editor_widget;
@@ -217,7 +278,11 @@ private:
     QString _monitor_server_port;
     bool _monitor_autoconnect;
 
+    /// Update _current_state and _tab_snapshots from the tabs and return the result.
+    /// Only the tabs changed since the last call are serialized again.
     MainWindow::SavedState saveCurrentState();
+    /// State recorded by the last undo step.
+    MainWindow::SavedState lastSavedState();
     void clearUndoStacks();
 };
 
@@ -475,6 +475,50 @@ void BehaviorTreeDataModel::restore(const QJsonObject &modelJson)
 
 }
 
+void BehaviorTreeDataModel::saveBinary(QDataStream &stream) const
+{
+    stream << instanceName();
+
+    stream << quint32( _ports_widgets.size() );
+    for (const auto& it: _ports_widgets)
+    {
+        stream << it.first;
+        if( auto linedit = dynamic_cast<QLineEdit*>(it.second)){
+            stream << linedit->text();
+        }
+        else if( auto combo = dynamic_cast<QComboBox*>(it.second)){
+            stream << combo->currentText();
+        }
+        else{
+            stream << QString();
+        }
+    }
+    stream << _collapsed << _collapse_nested;
+}
+
+void BehaviorTreeDataModel::restoreBinary(QDataStream &stream)
+{
+    QString alias;
+    stream >> alias;
+    setInstanceName( alias );
+
+    quint32 ports_count = 0;
+    stream >> ports_count;
+    for (quint32 i = 0; i < ports_count && stream.status() == QDataStream::Ok; i++)
+    {
+        QString port_name, value;
+        stream >> port_name >> value;
+        setPortMapping( port_name, value );
+    }
+    stream >> _collapsed >> _collapse_nested;
+
+    if (_collapsed)
+    {
+        // Defer until scene has restored connections
+        QTimer::singleShot(0, [this]() { setCollapsed(true); });
+    }
+}
+
 void BehaviorTreeDataModel::lock(bool locked)
 {
     _line_edit_name->setEnabled( !locked );
@@ -791,14 +835,23 @@ void BehaviorTreeDataModel::setCollapsed(bool collapsed)
     ngo->update();
     ngo->moveConnections();
 
-    // In Monitor mode (locked), reflow the entire tree so new node sizes are
-    // factored into positions; in Editor, don't auto-reflow.
+    // In Monitor mode (locked), reflow the subtree of this node so its new size
+    // is factored into positions; in Editor, don't auto-reflow.
     bool node_locked = !(ngo->flags() & QGraphicsItem::ItemIsMovable);
     if (node_locked)
     {
         auto abs_tree = BuildTreeFromScene(scene);
-        NodeReorder(*scene, abs_tree);
-        RefreshSceneGraphics(*scene);
+        auto moved_nodes = SubtreeReorder(*scene, abs_tree, this_node);
+
+        // the connections of the moved nodes are already updated: only the
+        // scene rect may need to grow
+        QRectF rect = ngo->mapToScene( ngo->boundingRect() ).boundingRect();
+        for (auto node: moved_nodes)
+        {
+            auto& node_ngo = node->nodeGraphicsObject();
+            rect = rect.united( node_ngo.mapToScene( node_ngo.boundingRect() ).boundingRect() );
+        }
+        scene->setSceneRect( scene->sceneRect().united( rect.adjusted(-50, -50, 50, 50) ) );
     }
 }
 
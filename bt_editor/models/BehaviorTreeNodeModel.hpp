@@ -74,6 +74,10 @@ public:
 
     void restore(QJsonObject const &) override;
 
+    void saveBinary(QDataStream& stream) const override;
+
+    void restoreBinary(QDataStream& stream) override;
+
     void lock(bool locked);
 
     void setPortMapping(const QString& port_name, const QString& value);
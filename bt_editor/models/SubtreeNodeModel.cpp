@@ -67,3 +67,17 @@ void SubtreeNodeModel::restore(const QJsonObject &modelJson)
     setInstanceName( alias );
     setExpanded( modelJson["expanded"].toBool() );
 }
+
+void SubtreeNodeModel::saveBinary(QDataStream &stream) const
+{
+    stream << instanceName() << _expanded;
+}
+
+void SubtreeNodeModel::restoreBinary(QDataStream &stream)
+{
+    QString alias;
+    bool expanded = false;
+    stream >> alias >> expanded;
+    setInstanceName( alias );
+    setExpanded( expanded );
+}
@@ -35,6 +35,10 @@ public:
 
     void restore(QJsonObject const &) override;
 
+    void saveBinary(QDataStream& stream) const override;
+
+    void restoreBinary(QDataStream& stream) override;
+
 signals:
     void expandButtonPushed();
 
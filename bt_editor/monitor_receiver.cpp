@@ -0,0 +1,232 @@
+#include "monitor_receiver.h"
+#include <QDebug>
+#include <deque>
+
+
+MonitorReceiver::MonitorReceiver(zmq::context_t &context, QObject *parent) :
+    QObject(parent),
+    _zmq_context(context),
+    _stop_requested(false),
+    _notify_pending(false)
+{
+}
+
+MonitorReceiver::~MonitorReceiver()
+{
+    stop();
+}
+
+void MonitorReceiver::start(const std::string &address)
+{
+    stop();
+
+    // discard what is left from a previous connection
+    MonitorBatch old_batch;
+    while( _queue.pop(old_batch) ) {}
+
+    // the tree of the new connection is not known yet
+    std::atomic_store( &_uid_table, std::shared_ptr<const StatusPacketDecoder::UidTable>() );
+
+    _stop_requested = false;
+    _notify_pending = false;
+    _thread = std::thread( &MonitorReceiver::receiveLoop, this, address );
+}
+
+void MonitorReceiver::stop()
+{
+    if( _thread.joinable() )
+    {
+        _stop_requested = true;
+        _thread.join();
+    }
+}
+
+bool MonitorReceiver::popBatch(MonitorBatch &batch)
+{
+    // reset the flag BEFORE reading, so that a batch pushed after this point
+    // will emit batchReady() again.
+    _notify_pending = false;
+    return _queue.pop( batch );
+}
+
+void MonitorReceiver::setUidTable(std::shared_ptr<const StatusPacketDecoder::UidTable> table)
+{
+    std::atomic_store( &_uid_table, std::move(table) );
+}
+
+void MonitorReceiver::receiveLoop(std::string address)
+{
+    try{
+        zmq::socket_t subscriber( _zmq_context, ZMQ_SUB );
+        subscriber.connect( address.c_str() );
+        subscriber.set(zmq::sockopt::subscribe, "");
+        subscriber.set(zmq::sockopt::rcvtimeo, _recv_timeout_ms);
+        subscriber.set(zmq::sockopt::linger, 0);
+
+        StatusPacketDecoder decoder;
+        std::vector<NodeStatusUpdate> updates;
+        std::deque<zmq::message_t> kept; // received while there is no table
+        MonitorBatch pending;
+        zmq::message_t msg;
+
+        auto receive = [&]()
+        {
+            if( decoder.uidTable() )
+            {
+                decodePacket( msg, decoder, pending, updates );
+            }
+            else
+            {
+                kept.push_back( std::move(msg) );
+                if( kept.size() > _max_kept_packets )
+                {
+                    kept.pop_front();
+                }
+            }
+        };
+
+        while( !_stop_requested )
+        {
+            auto table = std::atomic_load( &_uid_table );
+            if( table != decoder.uidTable() )
+            {
+                decoder.setUidTable( table );
+                if( pending.uid_table != table )
+                {
+                    // what is not delivered yet refers to the previous tree
+                    pending.updates.clear();
+                    pending.unknown_uid = false;
+                    pending.uid_table = table;
+                }
+            }
+            while( !kept.empty() && decoder.uidTable() )
+            {
+                decodePacket( kept.front(), decoder, pending, updates );
+                kept.pop_front();
+            }
+
+            if( subscriber.recv(msg, zmq::recv_flags::none) )
+            {
+                receive();
+                // drain whatever is already queued, without waiting
+                while( subscriber.recv(msg, zmq::recv_flags::dontwait) )
+                {
+                    receive();
+                }
+            }
+
+            // If the queue is full, keep accumulating into the pending batch:
+            // the GUI will receive everything at once when it catches up.
+            if( pending.msg_count > 0 && _queue.push( pending ) )
+            {
+                pending.clear();
+                pending.uid_table = decoder.uidTable();
+                if( !_notify_pending.exchange(true) )
+                {
+                    emit batchReady();
+                }
+            }
+        }
+    }
+    catch( zmq::error_t& err)
+    {
+        qDebug() << "ZMQ receive failed: " << err.what();
+    }
+}
+
+void MonitorReceiver::decodePacket(const zmq::message_t &msg, StatusPacketDecoder& decoder,
+                                   MonitorBatch &batch, std::vector<NodeStatusUpdate> &updates)
+{
+    // decoded in place, from the buffer of the message
+    const auto result = decoder.decode( static_cast<const char*>(msg.data()), msg.size(), updates );
+    batch.msg_count++;
+
+    if( result == StatusPacketDecoder::MALFORMED_PACKET )
+    {
+        batch.malformed_count++;
+    }
+    else if( result == StatusPacketDecoder::UNKNOWN_UID )
+    {
+        // Stop decoding until the GUI loads the tree again and sets its table,
+        // unless it has already done it in the meantime.
+        batch.unknown_uid = true;
+        auto used_table = decoder.uidTable();
+        std::atomic_compare_exchange_strong( &_uid_table, &used_table,
+                                             std::shared_ptr<const StatusPacketDecoder::UidTable>() );
+        decoder.clear();
+    }
+    else
+    {
+        batch.updates.insert( batch.updates.end(), updates.begin(), updates.end() );
+    }
+}
+
+void StatusFrame::reset(size_t nodes_count)
+{
+    _changed.clear();
+    _slot.assign( nodes_count, -1 );
+    _restarted = false;
+}
+
+void StatusFrame::clear()
+{
+    for(const auto& change: _changed)
+    {
+        _slot[change.index] = -1;
+    }
+    _changed.clear();
+    _restarted = false;
+}
+
+void StatusFrame::addTransition(int index, NodeStatus status)
+{
+    if( index < 0 || size_t(index) >= _slot.size() )
+    {
+        return;
+    }
+
+    // the first child of the root starts running again: the tree style is
+    // reset anyway, previous transitions will never be visible.
+    if( index == 1 && status == NodeStatus::RUNNING )
+    {
+        clear();
+        _restarted = true;
+        return;
+    }
+
+    int& slot = _slot[index];
+    if( slot < 0 )
+    {
+        slot = static_cast<int>(_changed.size());
+        _changed.push_back( {index, NodeStatus::IDLE, status, false} );
+    }
+    else
+    {
+        Change& change = _changed[slot];
+        change.prev_status = change.status;
+        change.status = status;
+        change.has_prev = true;
+    }
+}
+
+void StatusFrame::takeTransitions(std::vector<std::pair<int, NodeStatus>>& node_status)
+{
+    node_status.clear();
+    node_status.reserve( _changed.size() * 2 + 1 );
+
+    if( _restarted )
+    {
+        // this is what triggers the reset of the tree style
+        node_status.push_back( {1, NodeStatus::RUNNING} );
+    }
+
+    for(const auto& change: _changed)
+    {
+        if( change.has_prev )
+        {
+            node_status.push_back( {change.index, change.prev_status} );
+        }
+        node_status.push_back( {change.index, change.status} );
+    }
+    clear();
+}
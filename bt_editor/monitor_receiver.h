@@ -0,0 +1,131 @@
+#ifndef MONITOR_RECEIVER_H
+#define MONITOR_RECEIVER_H
+
+#include <QObject>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <string>
+#include <vector>
+#include <zmq.hpp>
+
+#include "bt_editor_base.h"
+#include "spsc_queue.h"
+#include "status_packet_decoder.h"
+
+/// The updates decoded from one or more consecutive status packets.
+struct MonitorBatch
+{
+    MonitorBatch(): msg_count(0), malformed_count(0), unknown_uid(false) {}
+
+    int msg_count;
+    int malformed_count;
+    /// The table used to decode the updates; if it is not the one of the
+    /// loaded tree, the batch refers to a previous tree.
+    std::shared_ptr<const StatusPacketDecoder::UidTable> uid_table;
+    std::vector<NodeStatusUpdate> updates;
+    /// A packet contained a UID that is not in uid_table: the tree must be
+    /// loaded again. The following packets are decoded with the next table.
+    bool unknown_uid;
+
+    void clear()
+    {
+        msg_count = 0;
+        malformed_count = 0;
+        uid_table.reset();
+        updates.clear();
+        unknown_uid = false;
+    }
+};
+
+/// Transitions received during one display frame, reduced to what is needed to
+/// draw the final state: for each node index, its latest status preceded by the
+/// one before it (getStyleFromStatus uses it), discarding whatever happened
+/// before the last restart of the tree.
+class StatusFrame
+{
+public:
+    StatusFrame(): _restarted(false) {}
+
+    /// Discard the content and resize for a tree with nodes_count nodes.
+    void reset(size_t nodes_count);
+
+    void addTransition(int index, NodeStatus status);
+
+    bool empty() const { return _changed.empty() && !_restarted; }
+
+    /// Move the content into node_status, in the format expected by
+    /// MainWindow::onChangeNodesStatus, and clear the frame.
+    void takeTransitions(std::vector<std::pair<int, NodeStatus>>& node_status);
+
+private:
+    struct Change
+    {
+        int index;
+        NodeStatus prev_status;
+        NodeStatus status;
+        bool has_prev;
+    };
+
+    void clear();
+
+    std::vector<int> _slot;        // node index -> position in _changed, or -1
+    std::vector<Change> _changed;  // in order of first change
+    bool _restarted;
+};
+
+/// Receives the status packets published by the BT::PublisherZMQ on a dedicated
+/// thread, decodes them and hands the batches to the GUI thread through a
+/// lock-free queue. batchReady() is emitted (at most once until the queue is
+/// read again) when new data is available.
+class MonitorReceiver : public QObject
+{
+    Q_OBJECT
+
+public:
+    /// Timeout of the blocking receive; it bounds how long stop() can take.
+    static constexpr int _recv_timeout_ms = 50;
+    /// Packets kept while waiting for a table; the oldest ones are discarded.
+    static constexpr size_t _max_kept_packets = 1024;
+
+    explicit MonitorReceiver(zmq::context_t& context, QObject *parent = nullptr);
+    ~MonitorReceiver() override;
+
+    /// Connect the SUB socket to address and start the receiving thread.
+    void start(const std::string& address);
+
+    /// Stop and join the receiving thread.
+    void stop();
+
+    bool isRunning() const { return _thread.joinable(); }
+
+    /// To be called from the GUI thread only. Returns false when there is nothing to read.
+    bool popBatch(MonitorBatch& batch);
+
+    /// To be called from the GUI thread when a tree is loaded. The packets
+    /// received while there is no table (before the first tree, or after an
+    /// unknown UID) are kept, up to _max_kept_packets, and decoded with it.
+    void setUidTable(std::shared_ptr<const StatusPacketDecoder::UidTable> table);
+
+signals:
+    void batchReady();
+
+private:
+    void receiveLoop(std::string address);
+
+    void decodePacket(const zmq::message_t& msg, StatusPacketDecoder& decoder,
+                      MonitorBatch& batch, std::vector<NodeStatusUpdate>& updates);
+
+    zmq::context_t& _zmq_context;
+
+    std::thread _thread;
+    std::atomic<bool> _stop_requested;
+    std::atomic<bool> _notify_pending;
+
+    SpscQueue<MonitorBatch, 64> _queue;
+
+    // shared with the receiving thread, read and written with std::atomic_load/store
+    std::shared_ptr<const StatusPacketDecoder::UidTable> _uid_table;
+};
+
+#endif // MONITOR_RECEIVER_H
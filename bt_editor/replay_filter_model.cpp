@@ -0,0 +1,190 @@
+#include "replay_filter_model.h"
+#include <algorithm>
+
+bool ReplayFilterModel::Filter::isEmpty() const
+{
+    return name.isEmpty() && types.empty() && (status_mask & 0x0F) == 0x0F &&
+           min_time == -std::numeric_limits<double>::infinity() &&
+           max_time == std::numeric_limits<double>::infinity();
+}
+
+ReplayFilterModel::ReplayFilterModel(ReplayLog &log, QObject *parent):
+    QAbstractProxyModel(parent),
+    _log(log),
+    _identity(true)
+{
+}
+
+void ReplayFilterModel::setSourceModel(QAbstractItemModel *source_model)
+{
+    beginResetModel();
+    if( sourceModel() )
+    {
+        disconnect( sourceModel(), nullptr, this, nullptr );
+    }
+    QAbstractProxyModel::setSourceModel(source_model);
+    if( source_model )
+    {
+        connect( source_model, &QAbstractItemModel::dataChanged,
+                 this, &ReplayFilterModel::onSourceDataChanged );
+        connect( source_model, &QAbstractItemModel::modelAboutToBeReset,
+                 this, [this]() { beginResetModel(); } );
+        connect( source_model, &QAbstractItemModel::modelReset,
+                 this, &ReplayFilterModel::onSourceReset );
+    }
+    updateRows();
+    endResetModel();
+}
+
+void ReplayFilterModel::setFilter(const Filter &filter)
+{
+    beginResetModel();
+    _filter = filter;
+    updateRows();
+    endResetModel();
+}
+
+void ReplayFilterModel::onSourceReset()
+{
+    updateRows();
+    endResetModel();
+}
+
+void ReplayFilterModel::updateRows()
+{
+    _rows.clear();
+    _identity = _filter.isEmpty();
+    if( _identity || _log.empty() )
+    {
+        return;
+    }
+
+    // the nodes are few: check them one by one
+    std::vector<int> nodes;
+    for(const auto& node: _log.tree().nodes())
+    {
+        if( !_filter.types.empty() && _filter.types.count(node.model.type) == 0 )
+        {
+            continue;
+        }
+        if( !_filter.name.isEmpty() && !node.instance_name.contains(_filter.name, Qt::CaseInsensitive) )
+        {
+            continue;
+        }
+        nodes.push_back( node.index );
+    }
+
+    // the time range becomes a range of rows
+    const double first_timestamp = _log.timestamp(0);
+    const uint32_t first_row = static_cast<uint32_t>( _log.lowerBoundTime( first_timestamp + _filter.min_time ) );
+    const uint32_t last_row  = static_cast<uint32_t>( _log.lowerBoundTime( first_timestamp + _filter.max_time ) );
+    const bool check_status = (_filter.status_mask & 0x0F) != 0x0F;
+
+    for(int node: nodes)
+    {
+        auto range = _log.nodeRows( node );
+        auto begin = std::lower_bound( range.first, range.second, first_row );
+        auto end   = std::upper_bound( begin, range.second, last_row );
+        for(auto it = begin; it != end; it++)
+        {
+            // lowerBoundTime(max_time) may point to a row after the range
+            if( _log.timestamp(*it) > first_timestamp + _filter.max_time )
+            {
+                break;
+            }
+            if( check_status &&
+                (_filter.status_mask & (1u << static_cast<int>(_log.transition(*it).status))) == 0 )
+            {
+                continue;
+            }
+            _rows.push_back( *it );
+        }
+    }
+    if( nodes.size() > 1 )
+    {
+        std::sort( _rows.begin(), _rows.end() );
+    }
+}
+
+int ReplayFilterModel::proxyRow(int source_row) const
+{
+    if( _identity )
+    {
+        return source_row;
+    }
+    auto it = std::lower_bound( _rows.begin(), _rows.end(), uint32_t(source_row) );
+    if( it == _rows.end() || *it != uint32_t(source_row) )
+    {
+        return -1;
+    }
+    return static_cast<int>( it - _rows.begin() );
+}
+
+QModelIndex ReplayFilterModel::mapToSource(const QModelIndex &proxy_index) const
+{
+    if( !proxy_index.isValid() || !sourceModel() )
+    {
+        return QModelIndex();
+    }
+    const int row = _identity ? proxy_index.row() : static_cast<int>( _rows[proxy_index.row()] );
+    return sourceModel()->index( row, proxy_index.column() );
+}
+
+QModelIndex ReplayFilterModel::mapFromSource(const QModelIndex &source_index) const
+{
+    if( !source_index.isValid() )
+    {
+        return QModelIndex();
+    }
+    const int row = proxyRow( source_index.row() );
+    return (row < 0) ? QModelIndex() : createIndex( row, source_index.column() );
+}
+
+QModelIndex ReplayFilterModel::index(int row, int column, const QModelIndex &parent) const
+{
+    if( parent.isValid() || row < 0 || row >= rowCount() || column < 0 || column >= columnCount() )
+    {
+        return QModelIndex();
+    }
+    return createIndex( row, column );
+}
+
+QModelIndex ReplayFilterModel::parent(const QModelIndex &) const
+{
+    return QModelIndex();
+}
+
+int ReplayFilterModel::rowCount(const QModelIndex &parent) const
+{
+    if( parent.isValid() || !sourceModel() )
+    {
+        return 0;
+    }
+    return _identity ? sourceModel()->rowCount() : static_cast<int>( _rows.size() );
+}
+
+int ReplayFilterModel::columnCount(const QModelIndex &parent) const
+{
+    if( parent.isValid() || !sourceModel() )
+    {
+        return 0;
+    }
+    return sourceModel()->columnCount();
+}
+
+void ReplayFilterModel::onSourceDataChanged(const QModelIndex &top_left,
+                                            const QModelIndex &bottom_right,
+                                            const QVector<int> &roles)
+{
+    int first = top_left.row();
+    int last = bottom_right.row();
+    if( !_identity )
+    {
+        first = static_cast<int>( std::lower_bound( _rows.begin(), _rows.end(), uint32_t(first) ) - _rows.begin() );
+        last  = static_cast<int>( std::upper_bound( _rows.begin(), _rows.end(), uint32_t(last) ) - _rows.begin() ) - 1;
+    }
+    if( first <= last )
+    {
+        emit dataChanged( index(first, top_left.column()), index(last, bottom_right.column()), roles );
+    }
+}
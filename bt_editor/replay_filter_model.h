@@ -0,0 +1,71 @@
+#ifndef REPLAY_FILTER_MODEL_H
+#define REPLAY_FILTER_MODEL_H
+
+#include <QAbstractProxyModel>
+#include <set>
+#include <limits>
+#include "replay_log.h"
+
+/// Filter of the replay table. Matching rows are collected from the posting
+/// lists of the ReplayLog (rows of each node), therefore the cost of a filter
+/// depends on the number of matching rows, not on the size of the log.
+class ReplayFilterModel : public QAbstractProxyModel
+{
+    Q_OBJECT
+
+public:
+    struct Filter
+    {
+        Filter():
+            status_mask(0xFF),
+            min_time( -std::numeric_limits<double>::infinity() ),
+            max_time( std::numeric_limits<double>::infinity() )
+        {}
+
+        QString name;               // case insensitive, part of the instance name
+        std::set<NodeType> types;   // empty: any type
+        unsigned status_mask;       // bit (1 << status) of the accepted status
+        double min_time;            // time relative to the first transition
+        double max_time;
+
+        bool isEmpty() const;
+    };
+
+    explicit ReplayFilterModel(ReplayLog& log, QObject *parent = nullptr);
+
+    void setSourceModel(QAbstractItemModel *source_model) override;
+
+    void setFilter(const Filter& filter);
+
+    const Filter& filter() const { return _filter; }
+
+    QModelIndex mapToSource(const QModelIndex &proxy_index) const override;
+
+    QModelIndex mapFromSource(const QModelIndex &source_index) const override;
+
+    QModelIndex index(int row, int column, const QModelIndex &parent = QModelIndex()) const override;
+
+    QModelIndex parent(const QModelIndex &child) const override;
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+
+private slots:
+    void onSourceDataChanged(const QModelIndex &top_left, const QModelIndex &bottom_right,
+                             const QVector<int> &roles);
+
+    void onSourceReset();
+
+private:
+    void updateRows();
+
+    int proxyRow(int source_row) const;
+
+    ReplayLog& _log;
+    Filter _filter;
+    bool _identity;
+    std::vector<uint32_t> _rows; // source rows, when !_identity
+};
+
+#endif // REPLAY_FILTER_MODEL_H
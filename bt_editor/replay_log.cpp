@@ -0,0 +1,293 @@
+#include "replay_log.h"
+#include <algorithm>
+#include "utils.h"
+
+const size_t ReplayLog::KEYFRAME_ROWS;
+const size_t ReplayLog::KEYFRAME_MIN_ROWS;
+constexpr double ReplayLog::KEYFRAME_SECONDS;
+
+namespace {
+
+inline uint8_t packStatus(NodeStatus prev_status, NodeStatus status)
+{
+    return static_cast<uint8_t>( (static_cast<int>(prev_status) << 4) | static_cast<int>(status) );
+}
+
+inline void applyTransition(uint8_t& packed, NodeStatus status)
+{
+    packed = static_cast<uint8_t>( ((packed & 0x0F) << 4) | static_cast<int>(status) );
+}
+
+}
+
+ReplayLog::ReplayLog():
+    _data(nullptr),
+    _size(0),
+    _transitions_offset(0),
+    _transitions_count(0)
+{
+}
+
+ReplayLog::Result ReplayLog::openFile(const QString &file_path)
+{
+    clear();
+
+    _file.setFileName( file_path );
+    if( !_file.open(QIODevice::ReadOnly) )
+    {
+        return CANNOT_OPEN;
+    }
+    if( _file.size() == 0 )
+    {
+        return EMPTY_FILE;
+    }
+    // the mapping stays valid after QFile::close()
+    uchar* mapped = _file.map( 0, _file.size() );
+    _file.close();
+    if( !mapped )
+    {
+        return CANNOT_OPEN;
+    }
+    _data = reinterpret_cast<const char*>(mapped);
+    _size = static_cast<size_t>(_file.size());
+    return parse();
+}
+
+ReplayLog::Result ReplayLog::setContent(const QByteArray &content)
+{
+    clear();
+    _content = content;
+    _data = _content.constData();
+    _size = static_cast<size_t>(_content.size());
+    return parse();
+}
+
+void ReplayLog::clear()
+{
+    if( _data && _content.isEmpty() )
+    {
+        _file.unmap( reinterpret_cast<uchar*>(const_cast<char*>(_data)) );
+    }
+    _content.clear();
+    _data = nullptr;
+    _size = 0;
+    _transitions_offset = 0;
+    _transitions_count = 0;
+    _tree.clear();
+    _uid_to_index.clear();
+    _restarts.clear();
+    _timepoints.clear();
+    _keyframe_rows.clear();
+    _keyframes.clear();
+    _node_rows_offset.clear();
+    _node_rows.clear();
+}
+
+ReplayLog::Result ReplayLog::parse()
+{
+    // we need at least 4 bytes to read the bt_header_size
+    if( _size < 4 )
+    {
+        return EMPTY_FILE;
+    }
+
+    // read the length of the header section from the file
+    const size_t bt_header_size = flatbuffers::ReadScalar<uint32_t>(_data);
+
+    // if the length of the header goes past the end of the file, it is invalid
+    if( (bt_header_size == 0) || (bt_header_size > _size - 4) )
+    {
+        return CORRUPTED_FILE;
+    }
+
+    flatbuffers::Verifier verifier( reinterpret_cast<const uint8_t*>(_data+4), _size - 4 );
+    if( !Serialization::VerifyBehaviorTreeBuffer(verifier) )
+    {
+        return INCOMPATIBLE_FORMAT;
+    }
+
+    auto res_pair = BuildTreeFromFlatbuffers( Serialization::GetBehaviorTree( &_data[4] ) );
+    _tree = std::move( res_pair.first );
+
+    _uid_to_index.assign( 0x10000, -1 );
+    for(const auto& it: res_pair.second)
+    {
+        if( it.first >= 0 && it.first < 0x10000 )
+        {
+            _uid_to_index[it.first] = static_cast<int16_t>(it.second);
+        }
+    }
+
+    _transitions_offset = 4 + bt_header_size;
+    _transitions_count = (_size - _transitions_offset) / 12;
+
+    // Single sequential pass: validate the UIDs and build the sparse index.
+    int idle_counter = _tree.nodes().size();
+    const int total_nodes = _tree.nodes().size();
+    double previous_timestamp = 0;
+
+    const uint8_t idle_pair = packStatus( NodeStatus::IDLE, NodeStatus::IDLE );
+    std::vector<uint8_t> current_status( total_nodes, idle_pair );
+    double keyframe_timestamp = (_transitions_count > 0) ? timestamp(0) : 0.0;
+
+    for(size_t row = 0; row < _transitions_count; row++)
+    {
+        const char* buffer = record(row);
+        const uint16_t uid = flatbuffers::ReadScalar<uint16_t>( &buffer[8] );
+        const int index = _uid_to_index[uid];
+        if( index < 0 )
+        {
+            clear();
+            return CORRUPTED_FILE;
+        }
+        const NodeStatus prev_status = convert(flatbuffers::ReadScalar<Serialization::NodeStatus>(&buffer[10] ));
+        const NodeStatus status      = convert(flatbuffers::ReadScalar<Serialization::NodeStatus>(&buffer[11] ));
+
+        if( index == 1 &&
+            (status == NodeStatus::RUNNING || status == NodeStatus::IDLE) &&
+            idle_counter >= total_nodes - 1 )
+        {
+            _restarts.push_back( static_cast<uint32_t>(row) );
+            std::fill( current_status.begin(), current_status.end(), idle_pair );
+        }
+        applyTransition( current_status[index], status );
+
+        if( prev_status != NodeStatus::IDLE && status == NodeStatus::IDLE )
+            idle_counter++;
+        else if( prev_status == NodeStatus::IDLE && status != NodeStatus::IDLE )
+            idle_counter--;
+
+        const double time = timestamp(row);
+        if( (time - previous_timestamp) >= 0.001 || row == _transitions_count-1 )
+        {
+            _timepoints.push_back( static_cast<uint32_t>(row) );
+            previous_timestamp = time;
+        }
+
+        const size_t rows_from_keyframe = _keyframe_rows.empty() ?
+                    row + 1 : row - _keyframe_rows.back();
+        if( rows_from_keyframe >= KEYFRAME_ROWS ||
+            ( (time - keyframe_timestamp) >= KEYFRAME_SECONDS &&
+              rows_from_keyframe >= KEYFRAME_MIN_ROWS ) )
+        {
+            _keyframe_rows.push_back( static_cast<uint32_t>(row) );
+            _keyframes.insert( _keyframes.end(), current_status.begin(), current_status.end() );
+            keyframe_timestamp = time;
+        }
+    }
+    return SUCCESS;
+}
+
+ReplayLog::Transition ReplayLog::transition(size_t row) const
+{
+    const char* buffer = record(row);
+    Transition trans;
+    trans.timestamp = timestamp(row);
+    trans.index = _uid_to_index[ flatbuffers::ReadScalar<uint16_t>( &buffer[8] ) ];
+    trans.prev_status = convert(flatbuffers::ReadScalar<Serialization::NodeStatus>(&buffer[10] ));
+    trans.status      = convert(flatbuffers::ReadScalar<Serialization::NodeStatus>(&buffer[11] ));
+    return trans;
+}
+
+double ReplayLog::timestamp(size_t row) const
+{
+    const char* buffer = record(row);
+    const double t_sec  = flatbuffers::ReadScalar<uint32_t>( &buffer[0] );
+    const double t_usec = flatbuffers::ReadScalar<uint32_t>( &buffer[4] );
+    return t_sec + t_usec* 0.000001;
+}
+
+size_t ReplayLog::nearestRestart(size_t row) const
+{
+    auto it = std::upper_bound( _restarts.begin(), _restarts.end(), static_cast<uint32_t>(row) );
+    if( it == _restarts.begin() )
+    {
+        return 0;
+    }
+    return *(it-1);
+}
+
+void ReplayLog::statusAt(size_t row, std::vector<NodeStatusPair> &nodes_status) const
+{
+    const size_t nodes_count = _tree.nodesCount();
+    const uint8_t idle_pair = packStatus( NodeStatus::IDLE, NodeStatus::IDLE );
+    std::vector<uint8_t> current_status( nodes_count, idle_pair );
+
+    // start from the nearest keyframe, unless the tree was restarted after it
+    size_t first_row = nearestRestart(row);
+
+    auto it = std::upper_bound( _keyframe_rows.begin(), _keyframe_rows.end(), static_cast<uint32_t>(row) );
+    if( it != _keyframe_rows.begin() && *(it-1) >= first_row )
+    {
+        const size_t keyframe = (it - 1) - _keyframe_rows.begin();
+        const auto keyframe_begin = _keyframes.begin() + keyframe * nodes_count;
+        std::copy( keyframe_begin, keyframe_begin + nodes_count, current_status.begin() );
+        first_row = *(it-1) + 1;
+    }
+
+    for(size_t t = first_row; t <= row && t < _transitions_count; t++)
+    {
+        const char* buffer = record(t);
+        const int index = _uid_to_index[ flatbuffers::ReadScalar<uint16_t>( &buffer[8] ) ];
+        applyTransition( current_status[index],
+                         convert(flatbuffers::ReadScalar<Serialization::NodeStatus>(&buffer[11] )) );
+    }
+
+    nodes_status.resize( nodes_count );
+    for(size_t i = 0; i < nodes_count; i++)
+    {
+        nodes_status[i].prev_status = static_cast<NodeStatus>( current_status[i] >> 4 );
+        nodes_status[i].status      = static_cast<NodeStatus>( current_status[i] & 0x0F );
+    }
+}
+
+size_t ReplayLog::lowerBoundTime(double time) const
+{
+    size_t first = 0;
+    size_t count = _transitions_count;
+    while( count > 0 )
+    {
+        const size_t step = count / 2;
+        if( timestamp(first + step) < time )
+        {
+            first += step + 1;
+            count -= step + 1;
+        }
+        else{
+            count = step;
+        }
+    }
+    return first;
+}
+
+std::pair<const uint32_t*, const uint32_t*> ReplayLog::nodeRows(int index)
+{
+    const size_t nodes_count = _tree.nodesCount();
+    if( _node_rows_offset.empty() && nodes_count > 0 )
+    {
+        // counting sort of the rows by node: two sequential passes
+        _node_rows_offset.assign( nodes_count + 1, 0 );
+        for(size_t row = 0; row < _transitions_count; row++)
+        {
+            const int node = _uid_to_index[ flatbuffers::ReadScalar<uint16_t>( &record(row)[8] ) ];
+            _node_rows_offset[node + 1]++;
+        }
+        for(size_t i = 0; i < nodes_count; i++)
+        {
+            _node_rows_offset[i + 1] += _node_rows_offset[i];
+        }
+        _node_rows.resize( _transitions_count );
+        std::vector<size_t> next( _node_rows_offset.begin(), _node_rows_offset.end() - 1 );
+        for(size_t row = 0; row < _transitions_count; row++)
+        {
+            const int node = _uid_to_index[ flatbuffers::ReadScalar<uint16_t>( &record(row)[8] ) ];
+            _node_rows[ next[node]++ ] = static_cast<uint32_t>(row);
+        }
+    }
+    if( index < 0 || size_t(index) >= nodes_count )
+    {
+        return { nullptr, nullptr };
+    }
+    const uint32_t* rows = _node_rows.data();
+    return { rows + _node_rows_offset[index], rows + _node_rows_offset[index + 1] };
+}
@@ -0,0 +1,119 @@
+#ifndef REPLAY_LOG_H
+#define REPLAY_LOG_H
+
+#include <QFile>
+#include <QByteArray>
+#include <vector>
+#include "bt_editor_base.h"
+
+/// Log file (.fbl) written by BT::FileLogger.
+///
+/// The transitions are not copied: they are read on demand from the file
+/// (memory-mapped) or from the buffer given to setContent(). Only a sparse
+/// index (rows where the tree restarts and rows where the time changes) is
+/// kept in memory, therefore the size of the log is limited only by the
+/// address space.
+class ReplayLog
+{
+public:
+    enum Result { SUCCESS, EMPTY_FILE, CORRUPTED_FILE, INCOMPATIBLE_FORMAT, CANNOT_OPEN };
+
+    /// Keyframes of the status of the tree are stored every KEYFRAME_ROWS
+    /// transitions or every KEYFRAME_SECONDS of log, whatever comes first.
+    /// A keyframe is stored by time only after KEYFRAME_MIN_ROWS transitions,
+    /// otherwise a log with sparse transitions would have one for each of them.
+    static const size_t KEYFRAME_ROWS = 1024;
+    static const size_t KEYFRAME_MIN_ROWS = KEYFRAME_ROWS / 16;
+    static constexpr double KEYFRAME_SECONDS = 10.0;
+
+    struct Transition
+    {
+        int16_t index;
+        double timestamp;
+        NodeStatus prev_status;
+        NodeStatus status;
+    };
+
+    ReplayLog();
+
+    ReplayLog(const ReplayLog&) = delete;
+    ReplayLog& operator=(const ReplayLog&) = delete;
+
+    /// Memory-map the file and index it.
+    Result openFile(const QString& file_path);
+
+    /// Index a log already in memory. The buffer is shared, not copied.
+    Result setContent(const QByteArray& content);
+
+    void clear();
+
+    const AbsBehaviorTree& tree() const { return _tree; }
+
+    size_t transitionsCount() const { return _transitions_count; }
+
+    bool empty() const { return _transitions_count == 0; }
+
+    /// O(1): the transition is decoded directly from the log.
+    Transition transition(size_t row) const;
+
+    double timestamp(size_t row) const;
+
+    /// Last row, not greater than row, where the tree was restarted.
+    size_t nearestRestart(size_t row) const;
+
+    /// First row with a timestamp not lower than time (timestamps are monotonic).
+    size_t lowerBoundTime(double time) const;
+
+    /// Rows of the transitions of the node, in increasing order.
+    /// The index (a posting list per node) is built the first time it is needed.
+    std::pair<const uint32_t*, const uint32_t*> nodeRows(int index);
+
+    /// Status of a node and the one it had before (IDLE after a restart).
+    struct NodeStatusPair
+    {
+        NodeStatus prev_status;
+        NodeStatus status;
+    };
+
+    /// Status of all the nodes after the transition at row. It is restored from
+    /// the nearest keyframe, applying only the transitions that follow it.
+    void statusAt(size_t row, std::vector<NodeStatusPair>& nodes_status) const;
+
+    size_t keyframesCount() const { return _keyframe_rows.size(); }
+
+    /// Rows where the timestamp moved forward of at least 1 millisecond
+    /// (the last row is always included). Used as steps of the time slider.
+    const std::vector<uint32_t>& timepoints() const { return _timepoints; }
+
+private:
+    Result parse();
+
+    const char* record(size_t row) const
+    {
+        return _data + _transitions_offset + 12*row;
+    }
+
+    QFile _file;
+    QByteArray _content;
+    const char* _data;
+    size_t _size;
+
+    size_t _transitions_offset;
+    size_t _transitions_count;
+
+    AbsBehaviorTree _tree;
+    std::vector<int16_t> _uid_to_index;
+    std::vector<uint32_t> _restarts;
+    std::vector<uint32_t> _timepoints;
+
+    // rows of the transitions of node i are in
+    // [_node_rows_offset[i], _node_rows_offset[i+1]) of _node_rows.
+    std::vector<size_t> _node_rows_offset;
+    std::vector<uint32_t> _node_rows;
+
+    // one byte per node (prev_status << 4 | status) per keyframe
+    std::vector<uint32_t> _keyframe_rows;
+    std::vector<uint8_t> _keyframes;
+};
+
+#endif // REPLAY_LOG_H
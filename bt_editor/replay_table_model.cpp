@@ -0,0 +1,170 @@
+#include "replay_table_model.h"
+#include <QColor>
+#include <QFont>
+#include <algorithm>
+
+namespace {
+
+const char* statusName(NodeStatus status)
+{
+    switch (status)
+    {
+    case NodeStatus::SUCCESS: return "SUCCESS";
+    case NodeStatus::FAILURE: return "FAILURE";
+    case NodeStatus::RUNNING: return "RUNNING";
+    case NodeStatus::IDLE:    return "IDLE";
+    }
+    return "";
+}
+
+QColor statusColor(NodeStatus status)
+{
+    switch (status)
+    {
+    case NodeStatus::SUCCESS: return QColor::fromRgb(22, 255, 22);
+    case NodeStatus::FAILURE: return QColor::fromRgb(255, 22, 22);
+    case NodeStatus::RUNNING: return QColor::fromRgb(250, 160, 20);
+    case NodeStatus::IDLE:    return QColor::fromRgb(222, 222, 222);
+    }
+    return QColor();
+}
+
+}
+
+ReplayTableModel::ReplayTableModel(const ReplayLog &log, QObject *parent):
+    QAbstractTableModel(parent),
+    _log(log),
+    _rows_count(0),
+    _current_row(-1),
+    _first_timestamp(0)
+{
+}
+
+void ReplayTableModel::reload()
+{
+    beginResetModel();
+    _rows_count = static_cast<int>( _log.transitionsCount() );
+    _first_timestamp = _log.empty() ? 0.0 : _log.timestamp(0);
+    _current_row = -1;
+    endResetModel();
+}
+
+void ReplayTableModel::setCurrentRow(int current_row, int first_visible_row, int last_visible_row)
+{
+    if( current_row == _current_row )
+    {
+        return;
+    }
+    int first = std::min(current_row, _current_row) + 1;
+    int last  = std::max(current_row, _current_row);
+    _current_row = current_row;
+
+    first = std::max( first, std::max(0, first_visible_row) );
+    last  = std::min( last, std::min(_rows_count - 1, last_visible_row) );
+
+    if( first <= last )
+    {
+        emit dataChanged( index(first, TIME_COLUMN), index(last, NAME_COLUMN),
+                          {Qt::BackgroundRole} );
+    }
+}
+
+int ReplayTableModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : _rows_count;
+}
+
+int ReplayTableModel::columnCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : COLUMNS_COUNT;
+}
+
+QVariant ReplayTableModel::data(const QModelIndex &index, int role) const
+{
+    if( !index.isValid() || index.row() >= _rows_count )
+    {
+        return QVariant();
+    }
+    const int row = index.row();
+    const int column = index.column();
+
+    switch( role )
+    {
+    case Qt::DisplayRole:
+    {
+        const auto trans = _log.transition(row);
+        switch( column )
+        {
+        case TIME_COLUMN:
+            return QString::number(trans.timestamp - _first_timestamp, 'f', 3);
+        case NAME_COLUMN:
+            return _log.tree().node( trans.index )->instance_name;
+        case PREV_STATUS_COLUMN:
+            return QString( statusName(trans.prev_status) );
+        case STATUS_COLUMN:
+            return QString( statusName(trans.status) );
+        }
+    } break;
+
+    case Qt::ToolTipRole:
+        if( column == TIME_COLUMN )
+        {
+            return QString("absolute time: %1").arg(_log.timestamp(row), 0, 'f', 3);
+        }
+        break;
+
+    case Qt::FontRole:
+        if( column == TIME_COLUMN && isTimepoint(row) )
+        {
+            QFont font;
+            font.setBold(true);
+            return font;
+        }
+        break;
+
+    case Qt::BackgroundRole:
+        if( column == PREV_STATUS_COLUMN )
+        {
+            return statusColor( _log.transition(row).prev_status );
+        }
+        if( column == STATUS_COLUMN )
+        {
+            return statusColor( _log.transition(row).status );
+        }
+        if( row <= _current_row )
+        {
+            return QColor::fromRgb(210, 210, 210);
+        }
+        break;
+
+    case Qt::ForegroundRole:
+        if( column == PREV_STATUS_COLUMN || column == STATUS_COLUMN )
+        {
+            return QColor::fromRgb(0, 0, 0);
+        }
+        break;
+    }
+    return QVariant();
+}
+
+QVariant ReplayTableModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if( orientation != Qt::Horizontal || role != Qt::DisplayRole )
+    {
+        return QAbstractTableModel::headerData(section, orientation, role);
+    }
+    switch( section )
+    {
+    case TIME_COLUMN:        return QString("Time");
+    case NAME_COLUMN:        return QString("Node Name");
+    case PREV_STATUS_COLUMN: return QString("Previous");
+    case STATUS_COLUMN:      return QString("Status");
+    }
+    return QVariant();
+}
+
+bool ReplayTableModel::isTimepoint(int row) const
+{
+    const auto& timepoints = _log.timepoints();
+    return std::binary_search( timepoints.begin(), timepoints.end(), uint32_t(row) );
+}
@@ -0,0 +1,45 @@
+#ifndef REPLAY_TABLE_MODEL_H
+#define REPLAY_TABLE_MODEL_H
+
+#include <QAbstractTableModel>
+#include "replay_log.h"
+
+/// Table of the transitions of a ReplayLog. Rows are not stored: data() reads
+/// them from the log, therefore only the visible rows have a cost.
+class ReplayTableModel : public QAbstractTableModel
+{
+    Q_OBJECT
+
+public:
+    enum Column { TIME_COLUMN = 0, NAME_COLUMN, PREV_STATUS_COLUMN, STATUS_COLUMN, COLUMNS_COUNT };
+
+    explicit ReplayTableModel(const ReplayLog& log, QObject *parent = nullptr);
+
+    /// To be called when the content of the log changes.
+    void reload();
+
+    /// Rows up to (and including) current_row are shown as "already played".
+    /// dataChanged() is emitted once, only for the visible rows that changed.
+    void setCurrentRow(int current_row, int first_visible_row, int last_visible_row);
+
+    int currentRow() const { return _current_row; }
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+
+    QVariant headerData(int section, Qt::Orientation orientation,
+                        int role = Qt::DisplayRole) const override;
+
+private:
+    bool isTimepoint(int row) const;
+
+    const ReplayLog& _log;
+    int _rows_count;
+    int _current_row;
+    double _first_timestamp;
+};
+
+#endif // REPLAY_TABLE_MODEL_H
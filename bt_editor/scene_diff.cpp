@@ -0,0 +1,287 @@
+#include "scene_diff.h"
+#include <algorithm>
+#include <tuple>
+#include <iterator>
+#include <cstring>
+
+#include <nodes/Node>
+#include <nodes/Connection>
+
+using namespace QtNodes;
+
+namespace {
+
+bool GetConnectionKey(const Connection& connection, ConnectionKey& key)
+{
+    const Node* out_node = connection.getNode(PortType::Out);
+    const Node* in_node  = connection.getNode(PortType::In);
+    if( !out_node || !in_node )
+    {
+        return false;
+    }
+    key = { out_node->id(), connection.getPortIndex(PortType::Out),
+            in_node->id(),  connection.getPortIndex(PortType::In) };
+    return true;
+}
+
+// Node::saveBinary() writes the position last
+const int POSITION_BYTES = 2 * sizeof(double);
+
+bool SameExceptPosition(const QByteArray& a, const QByteArray& b)
+{
+    return a.size() == b.size() && a.size() >= POSITION_BYTES &&
+           std::memcmp( a.constData(), b.constData(), a.size() - POSITION_BYTES ) == 0;
+}
+
+QPointF ReadPosition(const QByteArray& node_record)
+{
+    QDataStream stream( QByteArray::fromRawData(
+                            node_record.constData() + node_record.size() - POSITION_BYTES,
+                            POSITION_BYTES ) );
+    stream.setVersion( FlowScene::BinaryStreamVersion );
+    QPointF position;
+    stream >> position;
+    return position;
+}
+
+}
+
+void ConnectionKey::saveBinary(QDataStream &stream) const
+{
+    stream << out_id << qint32(out_index) << in_id << qint32(in_index) << false;
+}
+
+bool ConnectionKey::operator <(const ConnectionKey &other) const
+{
+    return std::tie(out_id, out_index, in_id, in_index) <
+           std::tie(other.out_id, other.out_index, other.in_id, other.in_index);
+}
+
+bool ConnectionKey::operator ==(const ConnectionKey &other) const
+{
+    return out_id == other.out_id && out_index == other.out_index &&
+           in_id == other.in_id && in_index == other.in_index;
+}
+
+SceneSnapshot::SceneSnapshot(const FlowScene &scene):
+    layout( scene.layout() )
+{
+    for(const auto& it: scene.nodes())
+    {
+        if( it.second )
+        {
+            QByteArray record;
+            QDataStream stream( &record, QIODevice::WriteOnly );
+            stream.setVersion( FlowScene::BinaryStreamVersion );
+            it.second->saveBinary( stream );
+            nodes.insert( {it.first, record} );
+        }
+    }
+
+    connections.reserve( scene.connections().size() );
+    for(const auto& it: scene.connections())
+    {
+        ConnectionKey key;
+        if( it.second && GetConnectionKey( *it.second, key ) )
+        {
+            connections.push_back( key );
+        }
+    }
+    std::sort( connections.begin(), connections.end() );
+}
+
+QByteArray SceneSnapshot::toBinary() const
+{
+    QByteArray data;
+    QDataStream stream( &data, QIODevice::WriteOnly );
+    stream.setVersion( FlowScene::BinaryStreamVersion );
+
+    stream << FlowScene::BinaryMagic << FlowScene::BinaryVersion;
+    stream << quint8( layout == PortLayout::Horizontal ? 0 : 1 );
+
+    stream << quint32( nodes.size() );
+    for(const auto& it: nodes)
+    {
+        stream.writeRawData( it.second.constData(), it.second.size() );
+    }
+
+    stream << quint32( connections.size() );
+    for(const auto& connection: connections)
+    {
+        connection.saveBinary( stream );
+    }
+    return data;
+}
+
+SceneDiff::SceneDiff(const SceneSnapshot &before, const SceneSnapshot &after):
+    _byte_size( sizeof(SceneDiff) )
+{
+    // nodes whose model changed are created again: their connections must be too.
+    std::vector<QUuid> recreated;
+
+    auto addChange = [&](const QUuid& id, const QByteArray& node_before, const QByteArray& node_after)
+    {
+        bool moved_only = SameExceptPosition( node_before, node_after );
+        if( !moved_only && !node_before.isEmpty() && !node_after.isEmpty() )
+        {
+            recreated.push_back( id );
+        }
+        _nodes.push_back( {id, node_before, node_after, moved_only} );
+        _byte_size += sizeof(NodeChange) + node_before.size() + node_after.size();
+    };
+
+    auto before_it = before.nodes.begin();
+    auto after_it  = after.nodes.begin();
+    while( before_it != before.nodes.end() || after_it != after.nodes.end() )
+    {
+        if( after_it == after.nodes.end() ||
+            (before_it != before.nodes.end() && before_it->first < after_it->first) )
+        {
+            addChange( before_it->first, before_it->second, QByteArray() );
+            before_it++;
+        }
+        else if( before_it == before.nodes.end() || after_it->first < before_it->first )
+        {
+            addChange( after_it->first, QByteArray(), after_it->second );
+            after_it++;
+        }
+        else
+        {
+            if( before_it->second != after_it->second )
+            {
+                addChange( before_it->first, before_it->second, after_it->second );
+            }
+            before_it++;
+            after_it++;
+        }
+    }
+
+    // recreated is already sorted, because the maps are
+    auto touchesRecreated = [&recreated](const ConnectionKey& key)
+    {
+        return std::binary_search( recreated.begin(), recreated.end(), key.out_id ) ||
+               std::binary_search( recreated.begin(), recreated.end(), key.in_id );
+    };
+
+    auto before_conn = before.connections.begin();
+    auto after_conn  = after.connections.begin();
+    while( before_conn != before.connections.end() || after_conn != after.connections.end() )
+    {
+        if( after_conn == after.connections.end() ||
+            (before_conn != before.connections.end() && *before_conn < *after_conn) )
+        {
+            _removed_connections.push_back( *before_conn++ );
+        }
+        else if( before_conn == before.connections.end() || *after_conn < *before_conn )
+        {
+            _added_connections.push_back( *after_conn++ );
+        }
+        else
+        {
+            if( touchesRecreated( *before_conn ) )
+            {
+                _removed_connections.push_back( *before_conn );
+                _added_connections.push_back( *after_conn );
+            }
+            before_conn++;
+            after_conn++;
+        }
+    }
+    _byte_size += sizeof(ConnectionKey) * (_removed_connections.size() + _added_connections.size());
+}
+
+void SceneDiff::apply(FlowScene &scene, bool forward) const
+{
+    const auto& connections_to_remove = forward ? _removed_connections : _added_connections;
+    const auto& connections_to_add    = forward ? _added_connections : _removed_connections;
+
+    if( !connections_to_remove.empty() )
+    {
+        std::vector<Connection*> to_delete;
+        for(const auto& it: scene.connections())
+        {
+            ConnectionKey key;
+            if( it.second && GetConnectionKey( *it.second, key ) &&
+                std::binary_search( connections_to_remove.begin(), connections_to_remove.end(), key ) )
+            {
+                to_delete.push_back( it.second.get() );
+            }
+        }
+        for(auto connection: to_delete)
+        {
+            scene.deleteConnection( *connection );
+        }
+    }
+
+    {
+        // the connections are updated once, when all the nodes are in place
+        QtNodes::ScopedNodesMove nodes_move( scene );
+        for(const auto& change: _nodes)
+        {
+            const QByteArray& target = forward ? change.after : change.before;
+
+            auto node_it = scene.nodes().find( change.id );
+            Node* node = (node_it != scene.nodes().end()) ? node_it->second.get() : nullptr;
+
+            if( change.moved_only )
+            {
+                if( node )
+                {
+                    scene.setNodePosition( *node, ReadPosition(target) );
+                }
+                continue;
+            }
+            if( node )
+            {
+                scene.removeNode( *node );
+            }
+            if( !target.isEmpty() )
+            {
+                QDataStream stream( target );
+                stream.setVersion( FlowScene::BinaryStreamVersion );
+                scene.restoreNode( stream );
+            }
+        }
+    }
+
+    const auto& nodes = scene.nodes();
+    for(const auto& key: connections_to_add)
+    {
+        auto out_it = nodes.find( key.out_id );
+        auto in_it  = nodes.find( key.in_id );
+        if( out_it != nodes.end() && in_it != nodes.end() )
+        {
+            scene.createConnection( *in_it->second, key.in_index,
+                                    *out_it->second, key.out_index );
+        }
+    }
+}
+
+void SceneDiff::apply(SceneSnapshot &snapshot, bool forward) const
+{
+    const auto& connections_to_remove = forward ? _removed_connections : _added_connections;
+    const auto& connections_to_add    = forward ? _added_connections : _removed_connections;
+
+    for(const auto& change: _nodes)
+    {
+        const QByteArray& target = forward ? change.after : change.before;
+        if( target.isEmpty() )
+        {
+            snapshot.nodes.erase( change.id );
+        }
+        else{
+            snapshot.nodes[change.id] = target;
+        }
+    }
+
+    std::vector<ConnectionKey> kept;
+    kept.reserve( snapshot.connections.size() );
+    std::set_difference( snapshot.connections.begin(), snapshot.connections.end(),
+                         connections_to_remove.begin(), connections_to_remove.end(),
+                         std::back_inserter(kept) );
+
+    snapshot.connections.clear();
+    std::set_union( kept.begin(), kept.end(),
+                    connections_to_add.begin(), connections_to_add.end(),
+                    std::back_inserter(snapshot.connections) );
+}
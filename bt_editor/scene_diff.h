@@ -0,0 +1,88 @@
+#ifndef SCENE_DIFF_H
+#define SCENE_DIFF_H
+
+#include <QByteArray>
+#include <QDataStream>
+#include <QUuid>
+#include <map>
+#include <vector>
+
+#include <nodes/FlowScene>
+
+/// A connection identified by the nodes and ports it links.
+/// Connections get a new id whenever they are restored, so that can not be used.
+struct ConnectionKey
+{
+    QUuid out_id;
+    int out_index;
+    QUuid in_id;
+    int in_index;
+
+    /// Same format of QtNodes::Connection::saveBinary() (no converters are used
+    /// by the BehaviorTree models).
+    void saveBinary(QDataStream& stream) const;
+
+    bool operator <(const ConnectionKey& other) const;
+    bool operator ==(const ConnectionKey& other) const;
+};
+
+/// Content of a FlowScene, indexed node by node so that two snapshots can be
+/// compared without serializing the whole scene.
+struct SceneSnapshot
+{
+    SceneSnapshot(): layout(QtNodes::PortLayout::Vertical) {}
+
+    explicit SceneSnapshot(const QtNodes::FlowScene& scene);
+
+    /// Same format of QtNodes::FlowScene::saveToBinary().
+    QByteArray toBinary() const;
+
+    bool operator ==(const SceneSnapshot& other) const
+    {
+        return layout == other.layout && nodes == other.nodes && connections == other.connections;
+    }
+
+    QtNodes::PortLayout layout;
+    std::map<QUuid, QByteArray> nodes;      // output of QtNodes::Node::saveBinary()
+    std::vector<ConnectionKey> connections; // sorted
+};
+
+/// The nodes and connections that differ between two snapshots of the same scene.
+/// A node that only moved is repositioned; any other change of a node is applied
+/// by creating it again, together with its connections.
+class SceneDiff
+{
+public:
+    SceneDiff(): _byte_size(0) {}
+
+    SceneDiff(const SceneSnapshot& before, const SceneSnapshot& after);
+
+    bool empty() const { return _nodes.empty() && _removed_connections.empty() &&
+                                _added_connections.empty(); }
+
+    /// Approximate memory used by this object.
+    size_t byteSize() const { return _byte_size; }
+
+    /// Bring a scene from "before" to "after" if forward is true, from "after"
+    /// to "before" otherwise. Nodes that are not part of the diff are not touched.
+    void apply(QtNodes::FlowScene& scene, bool forward) const;
+
+    /// As above, on a snapshot.
+    void apply(SceneSnapshot& snapshot, bool forward) const;
+
+private:
+    struct NodeChange
+    {
+        QUuid id;
+        QByteArray before; // empty if the node was created
+        QByteArray after;  // empty if the node was deleted
+        bool moved_only;
+    };
+
+    std::vector<NodeChange> _nodes;
+    std::vector<ConnectionKey> _removed_connections;
+    std::vector<ConnectionKey> _added_connections;
+    size_t _byte_size;
+};
+
+#endif // SCENE_DIFF_H
@@ -3,9 +3,9 @@
 #include <QLineEdit>
 #include <QPushButton>
 #include <QMessageBox>
-#include <QTimer>
 #include <QLabel>
 #include <QDebug>
+#include <algorithm>
 
 #include "mainwindow.h"
 #include "utils.h"
@@ -17,9 +17,14 @@ SidepanelMonitor::SidepanelMonitor(QWidget *parent,
     QFrame(parent),
     ui(new Ui::SidepanelMonitor),
     _zmq_context(1),
-    _zmq_subscriber(_zmq_context, ZMQ_SUB),
+    _tree_state(TreeState::NONE),
+    _tree_retry_min_ms(_tree_retry_default_min_ms),
+    _tree_retry_max_ms(_tree_retry_default_max_ms),
+    _tree_retry_delay_ms(_tree_retry_default_min_ms),
     _connected(false),
     _msg_count(0),
+    _loaded_tree_hash(0),
+    _loaded_tree_hash_valid(false),
     _parent(parent)
 {
     ui->setupUi(this);
@@ -38,130 +43,177 @@ SidepanelMonitor::SidepanelMonitor(QWidget *parent,
         ui->lineEdit_server->setText(server_port);
     }
 
-    _timer = new QTimer(this);
-    connect( _timer, &QTimer::timeout, this, &SidepanelMonitor::on_timer );
+    _receiver = new MonitorReceiver(_zmq_context, this);
+    connect( _receiver, &MonitorReceiver::batchReady,
+             this, &SidepanelMonitor::onBatchReady, Qt::QueuedConnection );
+
+    _frame_timer = new QTimer(this);
+    _frame_timer->setSingleShot(true);
+    connect( _frame_timer, &QTimer::timeout, this, &SidepanelMonitor::onFrameTimeout );
+
+    _tree_fetcher = new TreeFetcher(_zmq_context, this);
+    connect( _tree_fetcher, &TreeFetcher::replyReceived,
+             this, &SidepanelMonitor::onTreeReceived );
+    connect( _tree_fetcher, &TreeFetcher::requestFailed,
+             this, &SidepanelMonitor::onTreeRequestFailed );
+
+    _retry_timer = new QTimer(this);
+    _retry_timer->setSingleShot(true);
+    connect( _retry_timer, &QTimer::timeout, this, &SidepanelMonitor::requestTree );
 }
 
 SidepanelMonitor::~SidepanelMonitor()
 {
+    _tree_fetcher->cancel();
+    _receiver->stop();
     delete ui;
 }
 
 void SidepanelMonitor::clear()
 {
-    if( _connected ) this->on_Connect();
+    if( _connected || _tree_state != TreeState::NONE ) this->on_Connect();
+    // the scene is not guaranteed to contain the loaded tree anymore
+    _loaded_tree_hash_valid = false;
 }
 
-void SidepanelMonitor::on_timer()
+void SidepanelMonitor::set_tree_retry_backoff_ms(int min_ms, int max_ms)
 {
-    if( !_connected ) return;
+    _tree_retry_min_ms = min_ms;
+    _tree_retry_max_ms = std::max(min_ms, max_ms);
+}
 
-    zmq::message_t msg;
-    try{
-        while(  _zmq_subscriber.recv(msg) )
-        {
-            _msg_count++;
-            ui->labelCount->setText( QString("Messages received: %1").arg(_msg_count) );
+void SidepanelMonitor::onBatchReady()
+{
+    // while the tree is being requested, packets are left in the queue
+    if( !_connected || _tree_state != TreeState::LOADED ) return;
 
-            const char* buffer = reinterpret_cast<const char*>(msg.data());
+    while( _receiver->popBatch(_received_batch) )
+    {
+        _msg_count += _received_batch.msg_count;
 
-            const uint32_t header_size = flatbuffers::ReadScalar<uint32_t>( buffer );
-            const uint32_t num_transitions = flatbuffers::ReadScalar<uint32_t>( &buffer[4+header_size] );
+        if( _received_batch.malformed_count > 0 )
+        {
+            qDebug() << "Malformed status packets:" << _received_batch.malformed_count;
+        }
+        // decoded with the UIDs of a previous tree
+        if( _received_batch.uid_table != _uid_table )
+        {
+            continue;
+        }
 
-            std::vector<std::pair<int, NodeStatus>> node_status;
-            // check uid in the index, if failed load tree from server
-            try{
-                for(size_t offset = 4; offset < header_size +4; offset +=3 )
-                {
-                    const uint16_t uid = flatbuffers::ReadScalar<uint16_t>(&buffer[offset]);
-                    _uid_to_index.at(uid);
-                }
-
-                for(size_t t=0; t < num_transitions; t++)
-                {
-                    size_t offset = 8 + header_size + 12*t;
-                    const uint16_t uid = flatbuffers::ReadScalar<uint16_t>(&buffer[offset+8]);
-                    _uid_to_index.at(uid);
-                }
-
-                for(size_t offset = 4; offset < header_size +4; offset +=3 )
-                {
-                    const uint16_t uid = flatbuffers::ReadScalar<uint16_t>(&buffer[offset]);
-                    const uint16_t index = _uid_to_index.at(uid);
-                    AbstractTreeNode* node = _loaded_tree.node( index );
-                    node->status = convert(flatbuffers::ReadScalar<Serialization::NodeStatus>(&buffer[offset+2] ));
-                }
-
-                //qDebug() << "--------";
-                for(size_t t=0; t < num_transitions; t++)
-                {
-                    size_t offset = 8 + header_size + 12*t;
-
-                    // const double t_sec  = flatbuffers::ReadScalar<uint32_t>( &buffer[offset] );
-                    // const double t_usec = flatbuffers::ReadScalar<uint32_t>( &buffer[offset+4] );
-                    // double timestamp = t_sec + t_usec* 0.000001;
-                    const uint16_t uid = flatbuffers::ReadScalar<uint16_t>(&buffer[offset+8]);
-                    const uint16_t index = _uid_to_index.at(uid);
-                    // NodeStatus prev_status = convert(flatbuffers::ReadScalar<Serialization::NodeStatus>(&buffer[index+10] ));
-                    NodeStatus status  = convert(flatbuffers::ReadScalar<Serialization::NodeStatus>(&buffer[offset+11] ));
-
-                    _loaded_tree.node(index)->status = status;
-                    node_status.push_back( {index, status} );
-
-                }
-            }
-            catch( std::out_of_range& err) {
-                qDebug() << "Reload tree from server";
-                if( !getTreeFromServer() ) {
-                    _connected = false;
-                    ui->lineEdit_address->setDisabled(false);
-                    _timer->stop();
-                    connectionUpdate(false);
-                    return;
-                }
+        for(const auto& update: _received_batch.updates)
+        {
+            _loaded_tree.node(update.index)->status = update.status;
+            if( update.is_transition )
+            {
+                _status_frame.addTransition( update.index, update.status );
             }
+        }
 
-            // update the graphic part
-            emit changeNodeStyle( "BehaviorTree", node_status );
-
-            // lock editing of nodes
-            auto main_win = dynamic_cast<MainWindow*>( _parent );
-            main_win->lockEditing(true);
+        if( _received_batch.unknown_uid )
+        {
+            // check uid in the index, if failed load tree from server
+            qDebug() << "Reload tree from server";
+            requestTree();
+            return;
         }
     }
-    catch( zmq::error_t& err)
+
+    // everything received until the next frame is drawn at once
+    if( !_frame_timer->isActive() )
     {
-        qDebug() << "ZMQ receive failed: " << err.what();
+        _frame_timer->start(_frame_period_ms);
     }
 }
 
-bool SidepanelMonitor::getTreeFromServer()
+void SidepanelMonitor::onFrameTimeout()
 {
-    try{
-        zmq::message_t request(0);
-        zmq::message_t reply;
+    if( !_connected ) return;
 
-        zmq::socket_t  zmq_client( _zmq_context, ZMQ_REQ );
-        zmq_client.connect( _connection_address_req.c_str() );
+    if( !_status_frame.empty() )
+    {
+        _status_frame.takeTransitions( _frame_node_status );
+        emit changeNodeStyle( "BehaviorTree", _frame_node_status );
+    }
+    ui->labelCount->setText( QString("Messages received: %1").arg(_msg_count) );
+}
 
-        zmq_client.set(zmq::sockopt::rcvtimeo, _load_tree_timeout_ms);
+void SidepanelMonitor::requestTree()
+{
+    _retry_timer->stop();
+    _tree_state = TreeState::REQUESTED;
+    _tree_fetcher->request( _connection_address_req, _load_tree_timeout_ms );
+}
 
-        zmq_client.send(request, zmq::send_flags::none);
+void SidepanelMonitor::onTreeReceived(const QByteArray& reply)
+{
+    if( !loadTree(reply) )
+    {
+        onTreeRequestFailed();
+        return;
+    }
+    _tree_state = TreeState::LOADED;
+    _tree_retry_delay_ms = _tree_retry_min_ms;
 
-        auto bytes_received  = zmq_client.recv(reply, zmq::recv_flags::none);
-        if( !bytes_received || *bytes_received == 0 )
-        {
-            return false;
-        }
+    if( !_connected )
+    {
+        // After we try get a tree on connect, reset to the default timeout.
+        // This is done so that we only use the increased autoconnect timeout once.
+        this->set_load_tree_timeout_ms(_load_tree_default_timeout_ms);
 
-        const char* buffer = reinterpret_cast<const char*>(reply.data());
-        auto fb_behavior_tree = Serialization::GetBehaviorTree( buffer );
+        _connected = true;
+        connectionUpdate(true);
+    }
+    // process what was received while the tree was being loaded
+    onBatchReady();
+}
 
-        auto res_pair = BuildTreeFromFlatbuffers( fb_behavior_tree );
+void SidepanelMonitor::onTreeRequestFailed()
+{
+    if( !_connected )
+    {
+        this->set_load_tree_timeout_ms(_load_tree_default_timeout_ms);
+        disconnectFromServer();
+
+        QMessageBox::warning(this,
+                             tr("ZeroMQ connection"),
+                             tr("Was not able to connect to [%1]\n").arg(_connection_address_pub.c_str()),
+                             QMessageBox::Close);
+        return;
+    }
 
-        _loaded_tree  = std::move( res_pair.first );
-        _uid_to_index = std::move( res_pair.second );
+    // the robot is probably restarting: try again later, waiting longer every time
+    _tree_state = TreeState::WAITING_RETRY;
+    _retry_timer->start( _tree_retry_delay_ms );
+    _tree_retry_delay_ms = std::min( _tree_retry_delay_ms * 2, _tree_retry_max_ms );
+}
 
+bool SidepanelMonitor::loadTree(const QByteArray& reply)
+{
+    flatbuffers::Verifier verifier( reinterpret_cast<const uint8_t*>(reply.data()),
+                                    static_cast<size_t>(reply.size()) );
+    if( !Serialization::VerifyBehaviorTreeBuffer(verifier) )
+    {
+        qDebug() << "Invalid tree received from server";
+        return false;
+    }
+    auto fb_behavior_tree = Serialization::GetBehaviorTree( reply.data() );
+
+    auto res_pair = BuildTreeFromFlatbuffers( fb_behavior_tree );
+
+    _loaded_tree  = std::move( res_pair.first );
+    // the packets are decoded by the receiver thread, that shares the table
+    _uid_table = StatusPacketDecoder::makeUidTable( res_pair.second );
+    _receiver->setUidTable( _uid_table );
+    // pending transitions refer to the previous tree
+    _status_frame.reset( _loaded_tree.nodesCount() );
+
+    // the same tree (usually, the same robot restarted) is already in the scene;
+    // the hash is only a quick check, two different trees may have the same one
+    const uint tree_hash = TreeStructureHash( _loaded_tree );
+    if( !_loaded_tree_hash_valid || tree_hash != _loaded_tree_hash ||
+        !SameTreeStructure( _loaded_tree, _scene_tree ) )
+    {
         // add new models to registry
         for(const auto& tree_node: _loaded_tree.nodes())
         {
@@ -176,34 +228,43 @@ bool SidepanelMonitor::getTreeFromServer()
             loadBehaviorTree( _loaded_tree, "BehaviorTree" );
         }
         catch (std::exception& err) {
+            _loaded_tree_hash_valid = false;
             QMessageBox messageBox;
             messageBox.critical(this,"Error Connecting to remote server", err.what() );
             messageBox.show();
             return false;
         }
+        _scene_tree = _loaded_tree;
+        _loaded_tree_hash = tree_hash;
+        _loaded_tree_hash_valid = true;
+    }
 
-        std::vector<std::pair<int, NodeStatus>> node_status;
-        node_status.reserve(_loaded_tree.nodesCount());
-
-        //  qDebug() << "--------";
+    std::vector<std::pair<int, NodeStatus>> node_status;
+    node_status.reserve(_loaded_tree.nodesCount());
 
-        for(size_t t=0; t < _loaded_tree.nodesCount(); t++)
-        {
-            node_status.push_back( { t, _loaded_tree.nodes()[t].status } );
-        }
-        emit changeNodeStyle( "BehaviorTree", node_status );
-    }
-    catch( zmq::error_t& err)
+    for(size_t t=0; t < _loaded_tree.nodesCount(); t++)
     {
-        qDebug() << "ZMQ client receive failed: " << err.what();
-        return false;
+        node_status.push_back( { t, _loaded_tree.nodes()[t].status } );
     }
+    emit changeNodeStyle( "BehaviorTree", node_status );
     return true;
 }
 
+void SidepanelMonitor::disconnectFromServer()
+{
+    _connected = false;
+    _tree_state = TreeState::NONE;
+    ui->lineEdit_address->setDisabled(false);
+    ui->lineEdit_publisher->setDisabled(false);
+    _tree_fetcher->cancel();
+    _retry_timer->stop();
+    _receiver->stop();
+    _frame_timer->stop();
+}
+
 void SidepanelMonitor::on_Connect()
 {
-    if( !_connected )
+    if( !_connected && _tree_state == TreeState::NONE )
     {
         QString address = ui->lineEdit_address->text();
         if( address.isEmpty() )
@@ -233,20 +294,11 @@ void SidepanelMonitor::on_Connect()
             _connection_address_req = "tcp://" + address.toStdString() + ":" + server_port.toStdString();
 
             try{
-                _zmq_subscriber.connect( _connection_address_pub.c_str() );
-
-                int timeout_ms = 1;
-                _zmq_subscriber.set(zmq::sockopt::subscribe, "");
-                _zmq_subscriber.set(zmq::sockopt::rcvtimeo, timeout_ms);
-
-                if( !getTreeFromServer() )
-                {
-                    failed = true;
-                    _connected = false;
-                }
-                // After we try get a tree on connect, reset to the default timeout.
-                // This is done so that we only use the increased autoconnect timeout once.
-                this->set_load_tree_timeout_ms(_load_tree_default_timeout_ms);
+                // start receiving before asking for the tree, packets published
+                // in the meantime are queued by the receiver.
+                _receiver->start( _connection_address_pub );
+                _tree_retry_delay_ms = _tree_retry_min_ms;
+                requestTree();
             }
             catch(zmq::error_t& err)
             {
@@ -259,13 +311,12 @@ void SidepanelMonitor::on_Connect()
 
         if( !failed )
         {
-            _connected = true;
+            // connectionUpdate(true) is emitted when the tree is received
             ui->lineEdit_address->setDisabled(true);
             ui->lineEdit_publisher->setDisabled(true);
-            _timer->start(_timer_period_ms);
-            connectionUpdate(true);
         }
         else{
+            disconnectFromServer();
             QMessageBox::warning(this,
                                  tr("ZeroMQ connection"),
                                  tr("Was not able to connect to [%1]\n").arg(_connection_address_pub.c_str()),
@@ -273,11 +324,7 @@ void SidepanelMonitor::on_Connect()
         }
     }
     else{
-        _connected = false;
-        ui->lineEdit_address->setDisabled(false);
-        ui->lineEdit_publisher->setDisabled(false);
-        _timer->stop();
-
+        disconnectFromServer();
         connectionUpdate(false);
     }
 }
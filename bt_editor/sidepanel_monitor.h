@@ -2,9 +2,13 @@
 #define SIDEPANEL_MONITOR_H
 
 #include <QFrame>
+#include <QTimer>
 #include <zmq.hpp>
 
 #include "bt_editor_base.h"
+#include "monitor_receiver.h"
+#include "status_packet_decoder.h"
+#include "tree_fetcher.h"
 
 namespace Ui {
 class SidepanelMonitor;
@@ -15,12 +19,15 @@ class SidepanelMonitor : public QFrame
     Q_OBJECT
 
 public:
-    /// Timer period in milliseconds.
-    static constexpr int _timer_period_ms = 20;
+    /// Status updates are applied to the scene at most once per frame (milliseconds).
+    static constexpr int _frame_period_ms = 16;
     /// Default timeout to get behavior tree, in milliseconds.
     static constexpr int _load_tree_default_timeout_ms = 1000;
     /// Timeout to get behavior tree during autoconnect, in milliseconds.
     static constexpr int _load_tree_autoconnect_timeout_ms = 10000;
+    /// Default delays between two attempts to reload the tree, in milliseconds.
+    static constexpr int _tree_retry_default_min_ms = 250;
+    static constexpr int _tree_retry_default_max_ms = 4000;
 
     explicit SidepanelMonitor(QWidget *parent = nullptr,
                               const QString &address = "",
@@ -35,13 +42,25 @@ public:
         _load_tree_timeout_ms = timeout_ms;
     };
 
+    /// When the tree can not be reloaded, the delay before the next attempt
+    /// starts from min_ms and it is doubled every time, up to max_ms.
+    void set_tree_retry_backoff_ms(int min_ms, int max_ms);
+
 public slots:
 
     void on_Connect();
 
 private slots:
 
-    void on_timer();
+    void onBatchReady();
+
+    void onFrameTimeout();
+
+    void requestTree();
+
+    void onTreeReceived(const QByteArray& reply);
+
+    void onTreeRequestFailed();
 
 signals:
     void loadBehaviorTree(const AbsBehaviorTree& tree, const QString &bt_name );
@@ -57,9 +76,22 @@ private:
     Ui::SidepanelMonitor *ui;
 
     zmq::context_t _zmq_context;
-    zmq::socket_t  _zmq_subscriber;
 
-    QTimer* _timer;
+    MonitorReceiver* _receiver;
+    MonitorBatch _received_batch;
+
+    enum class TreeState { NONE, REQUESTED, WAITING_RETRY, LOADED };
+
+    TreeFetcher* _tree_fetcher;
+    QTimer* _retry_timer;
+    TreeState _tree_state;
+    int _tree_retry_min_ms;
+    int _tree_retry_max_ms;
+    int _tree_retry_delay_ms;
+
+    QTimer* _frame_timer;
+    StatusFrame _status_frame;
+    std::vector<std::pair<int, NodeStatus>> _frame_node_status;
 
     bool _connected;
     std::string _connection_address_pub;
@@ -68,9 +100,14 @@ private:
 
     int _load_tree_timeout_ms;  // Timeout to get behavior tree.
     AbsBehaviorTree _loaded_tree;
-    std::unordered_map<int, int> _uid_to_index;
+    std::shared_ptr<const StatusPacketDecoder::UidTable> _uid_table;
+    AbsBehaviorTree _scene_tree; // the tree loaded in the scene, as received
+    uint _loaded_tree_hash;
+    bool _loaded_tree_hash_valid;
+
+    bool loadTree(const QByteArray& reply);
 
-    bool getTreeFromServer();
+    void disconnectFromServer();
 
     QWidget *_parent;
 
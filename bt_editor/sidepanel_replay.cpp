@@ -8,10 +8,14 @@
 #include <QFileDialog>
 #include <QSettings>
 #include <QKeyEvent>
-#include <QStandardItem>
 #include <QModelIndex>
 #include <QTimer>
 #include <QMessageBox>
+#include <QHeaderView>
+#include <QFontMetrics>
+#include <QStyle>
+#include <QComboBox>
+#include <QDoubleSpinBox>
 
 #include "bt_editor_base.h"
 #include "mainwindow.h"
@@ -26,25 +30,48 @@ SidepanelReplay::SidepanelReplay(QWidget *parent) :
 {
     ui->setupUi(this);
 
-    _table_model = new QStandardItemModel(0,4, this);
+    _table_model = new ReplayTableModel(_log, this);
+    _filter_model = new ReplayFilterModel(_log, this);
+    _filter_model->setSourceModel(_table_model);
 
-    _table_model->setHeaderData(0,Qt::Horizontal, "Time");
-    _table_model->setHeaderData(1,Qt::Horizontal, "Node Name");
-    _table_model->setHeaderData(2,Qt::Horizontal, "Previous");
-    _table_model->setHeaderData(3,Qt::Horizontal, "Status");
-
-    ui->tableView->setModel(_table_model);
+    ui->tableView->setModel(_filter_model);
     ui->tableView->horizontalHeader()->setSectionResizeMode(1, QHeaderView::Stretch);
-
-    _layout_update_timer = new QTimer(this);
-    _layout_update_timer->setSingleShot(true);
-    connect( _layout_update_timer, &QTimer::timeout, this, &SidepanelReplay::onTimerUpdate );
+    // all the rows have the same height: the view does not need to measure them
+    ui->tableView->verticalHeader()->setSectionResizeMode(QHeaderView::Fixed);
 
 
     _play_timer = new QTimer(this);
     _play_timer->setSingleShot(true);
     connect( _play_timer, &QTimer::timeout, this, &SidepanelReplay::onPlayUpdate );
 
+    // the filter is applied when the user stops typing
+    _filter_timer = new QTimer(this);
+    _filter_timer->setSingleShot(true);
+    connect( _filter_timer, &QTimer::timeout, this, &SidepanelReplay::onFilterTimeout );
+
+    ui->comboBoxType->addItem( tr("All Types") );
+    for(NodeType type: {NodeType::ACTION, NodeType::CONDITION, NodeType::CONTROL,
+                        NodeType::DECORATOR, NodeType::SUBTREE})
+    {
+        ui->comboBoxType->addItem( QString::fromStdString( toStr(type) ), static_cast<int>(type) );
+    }
+    ui->comboBoxStatus->addItem( tr("All Status") );
+    for(NodeStatus status: {NodeStatus::IDLE, NodeStatus::RUNNING,
+                            NodeStatus::SUCCESS, NodeStatus::FAILURE})
+    {
+        ui->comboBoxStatus->addItem( QString::fromStdString( toStr(status) ), static_cast<int>(status) );
+    }
+
+    auto startFilterTimer = [this]() { _filter_timer->start(250); };
+    connect( ui->comboBoxType, static_cast<void (QComboBox::*)(int)>(&QComboBox::currentIndexChanged),
+             this, startFilterTimer );
+    connect( ui->comboBoxStatus, static_cast<void (QComboBox::*)(int)>(&QComboBox::currentIndexChanged),
+             this, startFilterTimer );
+    connect( ui->timeFrom, static_cast<void (QDoubleSpinBox::*)(double)>(&QDoubleSpinBox::valueChanged),
+             this, startFilterTimer );
+    connect( ui->timeTo, static_cast<void (QDoubleSpinBox::*)(double)>(&QDoubleSpinBox::valueChanged),
+             this, startFilterTimer );
+
     ui->tableView->installEventFilter(this);
 }
 
@@ -55,96 +82,39 @@ SidepanelReplay::~SidepanelReplay()
 
 void SidepanelReplay::clear()
 {
-    _table_model->setColumnCount(4);
-    _table_model->setRowCount(0);
+    _log.clear();
+    _table_model->reload();
 }
 
-void SidepanelReplay::updateTableModel(const AbsBehaviorTree& locaded_tree)
+void SidepanelReplay::updateTableModel()
 {
-    _table_model->setColumnCount(4);
-    _table_model->setRowCount(0);
+    const auto& timepoints = _log.timepoints();
 
-    const size_t transitions_count = _transitions.size();
-
-    auto createStatusItem = [](NodeStatus status) -> QStandardItem*
+    if( !_log.empty() )
     {
-        QStandardItem* item = nullptr;
-        switch (status)
-        {
-        case NodeStatus::SUCCESS:{
-            item = new QStandardItem("SUCCESS");
-            item->setBackground(QColor::fromRgb(22, 255, 22));
-        } break;
-        case NodeStatus::FAILURE:{
-            item = new QStandardItem("FAILURE");
-            item->setBackground(QColor::fromRgb(255, 22, 22));
-        } break;
-        case NodeStatus::RUNNING:{
-            item = new QStandardItem("RUNNING");
-            item->setBackground(QColor::fromRgb(250, 160, 20));
-        } break;
-        case NodeStatus::IDLE:{
-            item = new QStandardItem("IDLE");
-            item->setBackground(QColor::fromRgb(222, 222, 222));
-        } break;
-        }
-        item->setForeground(QColor::fromRgb(0, 0, 0));
-        return item;
-    };
-
-    if(  transitions_count > 0)
-    {
-        double previous_timestamp = 0;
-        const double first_timestamp = _transitions.front().timestamp;
-
-        for(size_t row=0; row < transitions_count; row++)
-        {
-            auto& trans = _transitions[row];
-            auto node  = locaded_tree.node( trans.index );
-
-            QString timestamp;
-            timestamp = QString("%1").arg(trans.timestamp - first_timestamp, 0, 'f', 3);
-
-            auto timestamp_item = new QStandardItem( timestamp );
-            timestamp = QString("absolute time: %1").arg(trans.timestamp, 0, 'f', 3);
-            timestamp_item->setToolTip( timestamp );
-
-            if(  (trans.timestamp - previous_timestamp) >= 0.001 || row == transitions_count-1)
-            {
-                _timepoint.push_back( {trans.timestamp, row}  );
-                previous_timestamp = trans.timestamp;
-
-                auto font = timestamp_item->font();
-                font.setBold(true);
-                timestamp_item->setFont(font);
-            }
-
-            QList<QStandardItem *> rowData;
-            rowData << timestamp_item;
-            rowData << new QStandardItem( node->instance_name );
-            rowData << createStatusItem( trans.prev_status );
-            rowData << createStatusItem( trans.status );
-            _table_model->appendRow(rowData);
-        }
-
-        emit _table_model->dataChanged( _table_model->index(0,0), _table_model->index( transitions_count-1, 3) );
-
-        ui->tableView->horizontalHeader()->setSectionResizeMode(0, QHeaderView::ResizeToContents);
-        ui->tableView->horizontalHeader()->setSectionResizeMode(1, QHeaderView::Stretch);
-        ui->tableView->horizontalHeader()->setSectionResizeMode(2, QHeaderView::ResizeToContents);
-        ui->tableView->horizontalHeader()->setSectionResizeMode(3, QHeaderView::ResizeToContents);
-        ui->tableView->verticalHeader()->minimumSize();
+        updateColumnsWidth();
     }
 
-    ui->label->setText( QString("of %1").arg( _timepoint.size() ) );
+    ui->label->setText( QString("of %1").arg( timepoints.size() ) );
 
     ui->spinBox->setValue(0);
-    ui->spinBox->setMaximum( std::max(0 , (int)_timepoint.size()-1) );
-    ui->spinBox->setEnabled( !_timepoint.empty() );
+    ui->spinBox->setMaximum( std::max(0 , (int)timepoints.size()-1) );
+    ui->spinBox->setEnabled( !timepoints.empty() );
     ui->timeSlider->setValue( 0 );
-    ui->timeSlider->setMaximum( std::max(0 , (int)_timepoint.size()-1) );
-    ui->timeSlider->setEnabled( !_timepoint.empty() );
-    ui->pushButtonPlay->setEnabled( !_timepoint.empty() );
+    ui->timeSlider->setMaximum( std::max(0 , (int)timepoints.size()-1) );
+    ui->timeSlider->setEnabled( !timepoints.empty() );
+    ui->pushButtonPlay->setEnabled( !timepoints.empty() );
+
+    // the whole log is shown when the time range is the one of the log
+    const double duration = _log.empty() ? 0.0 :
+                            _log.timestamp( _log.transitionsCount() - 1 ) - _log.timestamp(0);
+    for(QDoubleSpinBox* time_box: {ui->timeFrom, ui->timeTo})
+    {
+        time_box->setMaximum( duration );
+        time_box->setEnabled( !_log.empty() );
+    }
+    ui->timeFrom->setValue( 0 );
+    ui->timeTo->setValue( ui->timeTo->maximum() );
 }
 
 void SidepanelReplay::on_LoadLog()
@@ -161,68 +131,47 @@ void SidepanelReplay::on_LoadLog()
     {
         return;
     }
-    QFile file(fileName);
-
-    if (!file.open(QIODevice::ReadOnly)){
-        return;
-    }
-
     directory_path = QFileInfo(fileName).absolutePath();
     settings.setValue("SidepanelReplay.lastLoadDirectory", directory_path);
     settings.sync();
 
-    QByteArray content = file.readAll();
-    loadLog( content );
+    // the file is memory-mapped, not read
+    onLogLoaded( _log.openFile(fileName) );
 }
 
 void SidepanelReplay::loadLog(const QByteArray &content)
 {
-    const char* buffer = reinterpret_cast<const char*>(content.data());
+    onLogLoaded( _log.setContent(content) );
+}
 
-    // how many bytes did we read off the disk (uoffset_t aka uint32_t)
-    const auto read_bytes = content.size();
+void SidepanelReplay::onLogLoaded(ReplayLog::Result result)
+{
+    // the previous content of the log is gone, also on failure
+    _table_model->reload();
 
-    // we need at least 4 bytes to read the bt_header_size
-    if( read_bytes < 4 ) {
+    switch( result )
+    {
+    case ReplayLog::SUCCESS: break;
+    case ReplayLog::CANNOT_OPEN:
+        return;
+    case ReplayLog::EMPTY_FILE:
         QMessageBox::warning( this, "Log file is empty",
                              "Failed to load this file.\n"
                              "This Log file is empty");
         return;
-    }
-    
-    // read the length of the header section from the file
-    const size_t bt_header_size = flatbuffers::ReadScalar<uint32_t>(buffer);
-
-    // if the length of the header goes past the end of the file, it is invalid
-    if( (bt_header_size == 0) || (bt_header_size > read_bytes) ) {
+    case ReplayLog::CORRUPTED_FILE:
         QMessageBox::warning( this, "Log file is corrupt",
                              "Failed to load this file.\n"
                              "This Log file corrupted or truncated");
         return;
-    }
-
-    flatbuffers::Verifier verifier( reinterpret_cast<const uint8_t*>(buffer+4),
-                                   size_t(content.size() -4));
-
-    bool valid_tree = Serialization::VerifyBehaviorTreeBuffer(verifier);
-    if( ! valid_tree )
-    {
+    case ReplayLog::INCOMPATIBLE_FORMAT:
         QMessageBox::warning( this, "Flatbuffer verification failed",
                              "Failed to load this file.\n"
                              "Its format is not compatible with the current one");
         return;
     }
 
-
-    auto fb_behavior_tree = Serialization::GetBehaviorTree( &buffer[4] );
-
-
-    auto res_pair = BuildTreeFromFlatbuffers( fb_behavior_tree );
-
-    _loaded_tree  = res_pair.first;
-    const auto& uid_to_index = res_pair.second;
-
-    for (const auto& tree_node: _loaded_tree.nodes() )
+    for (const auto& tree_node: _log.tree().nodes() )
     {
         const QString& ID = tree_node.model.registration_ID;
         if( BuiltinNodeModels().count( ID ) == 0)
@@ -231,49 +180,10 @@ void SidepanelReplay::loadLog(const QByteArray &content)
         }
     }
 
-    emit loadBehaviorTree( _loaded_tree, "BehaviorTree" );
-
-    _transitions.clear();
-    _transitions.reserve( (content.size() - 4 - bt_header_size) / 12 );
-
-    int idle_counter = _loaded_tree.nodes().size();
-    const int total_nodes = _loaded_tree.nodes().size();
-    int nearest_restart_transition_index = 0;
-
-    for (size_t offset = 4+bt_header_size; offset < content.size(); offset += 12)
-    {
-        Transition transition;
-        const double t_sec  = flatbuffers::ReadScalar<uint32_t>( &buffer[offset] );
-        const double t_usec = flatbuffers::ReadScalar<uint32_t>( &buffer[offset+4] );
-        double timestamp = t_sec + t_usec* 0.000001;
-        transition.timestamp = timestamp;
-        const uint16_t uid = flatbuffers::ReadScalar<uint16_t>(&buffer[offset+8]);
-        transition.index = uid_to_index.at(uid);
-        transition.prev_status = convert(flatbuffers::ReadScalar<Serialization::NodeStatus>(&buffer[offset+10] ));
-        transition.status      = convert(flatbuffers::ReadScalar<Serialization::NodeStatus>(&buffer[offset+11] ));
-        transition.is_tree_restart = false;
-
-        if(transition.index == 1 &&
-                (transition.status == NodeStatus::RUNNING || transition.status == NodeStatus::IDLE) &&
-                idle_counter >= total_nodes - 1){
-            transition.is_tree_restart = true;
-            nearest_restart_transition_index = _transitions.size();
-        }
-
-        if(transition.prev_status != NodeStatus::IDLE && transition.status == NodeStatus::IDLE)
-            idle_counter++;
-        else if(transition.prev_status == NodeStatus::IDLE && transition.status != NodeStatus::IDLE)
-            idle_counter--;
-
-        transition.nearest_restart_transition_index = nearest_restart_transition_index;
-
-        _transitions.push_back(transition);
-    }
+    emit loadBehaviorTree( _log.tree(), "BehaviorTree" );
 
-    _timepoint.clear();
     _prev_row = -1;
-    updateTableModel(_loaded_tree);
-
+    updateTableModel();
 
     // We need to lock the nodes after they are loaded
     auto main_win = dynamic_cast<MainWindow*>( _parent );
@@ -288,9 +198,9 @@ void SidepanelReplay::on_spinBox_valueChanged(int value)
         ui->timeSlider->setValue( value );
     }
 
-    int row = _timepoint[value].second;
+    int row = _log.timepoints()[value];
 
-    ui->tableView->scrollTo( _table_model->index(row,0), QAbstractItemView::PositionAtCenter  );
+    ui->tableView->scrollTo( viewIndex(row), QAbstractItemView::PositionAtCenter  );
 
     onRowChanged( row );
 }
@@ -302,8 +212,8 @@ void SidepanelReplay::on_timeSlider_valueChanged(int value)
         ui->spinBox->setValue( value );
     }
 
-    int row = _timepoint[value].second;
-    ui->tableView->scrollTo( _table_model->index(row,0), QAbstractItemView::PositionAtCenter);
+    int row = _log.timepoints()[value];
+    ui->tableView->scrollTo( viewIndex(row), QAbstractItemView::PositionAtCenter);
 
     onRowChanged( row );
 }
@@ -319,44 +229,48 @@ void SidepanelReplay::onRowChanged(int current_row)
         return;
     }
 
-    // disable section resize, otherwise it will be SUPER slow
-    // We will refresh this in the callback of _layout_update_timer -> onTimerUpdate
-    ui->tableView->horizontalHeader()->setSectionResizeMode (QHeaderView::Fixed);
-    ui->tableView->verticalHeader()->setSectionResizeMode (QHeaderView::Fixed);
-
-    const auto selected_color   = QColor::fromRgb(210, 210, 210);
-    const auto unselected_color = QColor::fromRgb(255, 255, 255);
-
-    for (int row = std::max(0,_prev_row); row <= current_row; row++)
+    // only the visible rows need to be repainted, the others
+    // will read the new cursor when they are scrolled into view.
+    int first_visible = ui->tableView->rowAt( 0 );
+    int last_visible = ui->tableView->rowAt( ui->tableView->viewport()->height() - 1 );
+    if( last_visible < 0 )
     {
-        _table_model->item(row, 0)->setBackground( selected_color );
-        _table_model->item(row, 1)->setBackground( selected_color );
+        last_visible = _filter_model->rowCount() - 1;
     }
-    for (int row = current_row+1; row <= _prev_row; row++)
-    {
-        _table_model->item(row, 0)->setBackground( unselected_color );
-        _table_model->item(row, 1)->setBackground( unselected_color );
-    }
-
-    // cancel the refresh of the layout refresh
-    if( !_layout_update_timer->isActive() )
+    first_visible = _filter_model->mapToSource( _filter_model->index(first_visible, 0) ).row();
+    last_visible  = _filter_model->mapToSource( _filter_model->index(last_visible, 0) ).row();
+    if( first_visible < 0 || last_visible < 0 )
     {
-        _layout_update_timer->stop();
+        first_visible = 0;
+        last_visible = -1;
     }
-    _layout_update_timer->start(100);
+    _table_model->setCurrentRow( current_row, first_visible, last_visible );
 
     const QString bt_name("BehaviorTree");
 
+    std::vector<ReplayLog::NodeStatusPair> nodes_status;
+    _log.statusAt( current_row, nodes_status );
+
+    // The previous status is sent too, because the style of an IDLE node depends on it.
+    // The first child of the root goes first: when RUNNING, it resets the style of the tree.
     std::vector<std::pair<int, NodeStatus>>  node_status;
-    for(size_t index = 0; index < _loaded_tree.nodes().size(); index++ )
+    node_status.reserve( nodes_status.size() * 2 );
+
+    auto pushNodeStatus = [&](int index)
     {
-        node_status.push_back( { index, NodeStatus::IDLE} );
+        node_status.push_back( { index, nodes_status[index].prev_status} );
+        node_status.push_back( { index, nodes_status[index].status} );
+    };
+    if( nodes_status.size() > 1 )
+    {
+        pushNodeStatus( 1 );
     }
-
-    for (int t = _transitions[current_row].nearest_restart_transition_index; t <= current_row; t++)
+    for(size_t index = 0; index < nodes_status.size(); index++ )
     {
-        auto& trans = _transitions[t];
-        node_status.push_back( { trans.index, trans.status} );
+        if( index != 1 )
+        {
+            pushNodeStatus( index );
+        }
     }
 
     emit changeNodeStyle( bt_name, node_status );
@@ -366,17 +280,14 @@ void SidepanelReplay::onRowChanged(int current_row)
 
 void SidepanelReplay::updatedSpinAndSlider(int row)
 {
-    auto it = std::upper_bound( _timepoint.begin(), _timepoint.end(), row,
-                                []( int val, const std::pair<double,int>& a ) -> bool
-    {
-        return val < a.second;
-    } );
+    const auto& timepoints = _log.timepoints();
+    auto it = std::upper_bound( timepoints.begin(), timepoints.end(), uint32_t(row) );
 
     QSignalBlocker block_spin( ui->spinBox );
     QSignalBlocker block_Slider( ui->timeSlider );
 
-    int index = (it - _timepoint.begin()) -1;
-    index = std::min( index, static_cast<int>(_timepoint.size()) -1 );
+    int index = (it - timepoints.begin()) -1;
+    index = std::min( index, static_cast<int>(timepoints.size()) -1 );
     index = std::max( index, 0 );
 
     ui->spinBox->setValue(index);
@@ -406,7 +317,7 @@ bool SidepanelReplay::eventFilter(QObject *object, QEvent *event)
             {
                 onRowChanged( next_row);
                 updatedSpinAndSlider( next_row );
-                ui->tableView->scrollTo( _table_model->index(next_row,0),
+                ui->tableView->scrollTo( viewIndex(next_row),
                                          QAbstractItemView::EnsureVisible);
             }
             return true;
@@ -420,17 +331,35 @@ void SidepanelReplay::on_tableView_clicked(const QModelIndex &index)
     // disable during play
     if( !ui->pushButtonPlay->isChecked())
     {
-        onRowChanged( index.row() );
-        updatedSpinAndSlider( index.row() );
+        const int row = _filter_model->mapToSource(index).row();
+        onRowChanged( row );
+        updatedSpinAndSlider( row );
     }
 }
 
-void SidepanelReplay::onTimerUpdate()
+void SidepanelReplay::updateColumnsWidth()
 {
-    ui->tableView->horizontalHeader()->setSectionResizeMode(0, QHeaderView::ResizeToContents);
-    ui->tableView->horizontalHeader()->setSectionResizeMode(1, QHeaderView::Stretch);
-    ui->tableView->horizontalHeader()->setSectionResizeMode(2, QHeaderView::ResizeToContents);
-    ui->tableView->horizontalHeader()->setSectionResizeMode(3, QHeaderView::ResizeToContents);
+    // Columns are sized once, when the log is loaded. Contents-based resize
+    // modes would measure the rows again every time the data changes.
+    auto header = ui->tableView->horizontalHeader();
+    header->setSectionResizeMode(QHeaderView::Interactive);
+    header->setSectionResizeMode(ReplayTableModel::NAME_COLUMN, QHeaderView::Stretch);
+
+    ui->tableView->resizeColumnToContents(ReplayTableModel::TIME_COLUMN);
+    ui->tableView->resizeColumnToContents(ReplayTableModel::PREV_STATUS_COLUMN);
+    ui->tableView->resizeColumnToContents(ReplayTableModel::STATUS_COLUMN);
+
+    // the widest time is the one of the last row, probably not visible now
+    QFont font = ui->tableView->font();
+    font.setBold(true);
+    const QString last_time = _table_model->index( _table_model->rowCount()-1,
+                                                   ReplayTableModel::TIME_COLUMN ).data().toString();
+    const int time_width = QFontMetrics(font).horizontalAdvance(last_time) +
+                           2 * ui->tableView->style()->pixelMetric(QStyle::PM_FocusFrameHMargin) + 8;
+    if( time_width > header->sectionSize(ReplayTableModel::TIME_COLUMN) )
+    {
+        header->resizeSection(ReplayTableModel::TIME_COLUMN, time_width);
+    }
 }
 
 void SidepanelReplay::on_pushButtonPlay_toggled(bool checked)
@@ -444,20 +373,20 @@ void SidepanelReplay::on_pushButtonPlay_toggled(bool checked)
         onPlayUpdate();
     }
     else{
-        ui->tableView->scrollTo( _table_model->index( _prev_row,0),
+        ui->tableView->scrollTo( viewIndex(_prev_row),
                                  QAbstractItemView::PositionAtCenter);
     }
 }
 
 void SidepanelReplay::onPlayUpdate()
 {
-    if( !ui->pushButtonPlay->isChecked() || _transitions.empty() )
+    if( !ui->pushButtonPlay->isChecked() || _log.empty() )
     {
         return;
     }  
 
     using namespace std::chrono;
-    const int LAST_ROW = _transitions.size()-1;
+    const int LAST_ROW = _log.transitionsCount()-1;
 
     _next_row = std::max(0, _next_row);
     _next_row = std::min(LAST_ROW, _next_row);
@@ -466,14 +395,14 @@ void SidepanelReplay::onPlayUpdate()
 
     // move forward as long as timestamp difference is small.
     while( _next_row < LAST_ROW -1 &&
-           (_transitions[_next_row+1].timestamp - _transitions[_next_row].timestamp) < TIME_DIFFERENCE_THRESHOLD )
+           (_log.timestamp(_next_row+1) - _log.timestamp(_next_row)) < TIME_DIFFERENCE_THRESHOLD )
     {
         _next_row++;
     }
 
     onRowChanged( _next_row );
     updatedSpinAndSlider( _next_row );
-    ui->tableView->scrollTo( _table_model->index(_next_row,0), QAbstractItemView::EnsureVisible  );
+    ui->tableView->scrollTo( viewIndex(_next_row), QAbstractItemView::EnsureVisible  );
 
     if( _next_row == LAST_ROW)
     {
@@ -481,8 +410,8 @@ void SidepanelReplay::onPlayUpdate()
         return;
     }
 
-    const double prev_time = _transitions[_next_row].timestamp;
-    const double next_time = _transitions[_next_row+1].timestamp;
+    const double prev_time = _log.timestamp(_next_row);
+    const double next_time = _log.timestamp(_next_row+1);
     int delay_relative = (next_time - prev_time) * 1000;
 
     _next_row++;
@@ -491,17 +420,40 @@ void SidepanelReplay::onPlayUpdate()
     _play_timer->start(delay_relative);
 }
 
-void SidepanelReplay::on_lineEditFilter_textChanged(const QString &filter_text)
+void SidepanelReplay::on_lineEditFilter_textChanged(const QString &)
 {
-    for (int row=0; row < _table_model->rowCount(); row++ )
+    _filter_timer->start(250);
+}
+
+void SidepanelReplay::onFilterTimeout()
+{
+    ReplayFilterModel::Filter filter;
+    filter.name = ui->lineEditFilter->text();
+    if( ui->comboBoxType->currentIndex() > 0 )
+    {
+        filter.types.insert( static_cast<NodeType>( ui->comboBoxType->currentData().toInt() ) );
+    }
+    if( ui->comboBoxStatus->currentIndex() > 0 )
     {
-        bool show = _table_model->item(row,1)->text().contains(filter_text, Qt::CaseInsensitive);
+        filter.status_mask = 1u << ui->comboBoxStatus->currentData().toInt();
+    }
+    if( ui->timeFrom->value() > ui->timeFrom->minimum() )
+    {
+        filter.min_time = ui->timeFrom->value();
+    }
+    if( ui->timeTo->value() < ui->timeTo->maximum() )
+    {
+        filter.max_time = ui->timeTo->value();
+    }
+    _filter_model->setFilter( filter );
 
-        if( show ){
-            ui->tableView->showRow(row);
-        }
-        else{
-            ui->tableView->hideRow(row);
-        }
+    if( _prev_row >= 0 )
+    {
+        ui->tableView->scrollTo( viewIndex(_prev_row), QAbstractItemView::PositionAtCenter );
     }
 }
+
+QModelIndex SidepanelReplay::viewIndex(int row) const
+{
+    return _filter_model->mapFromSource( _table_model->index(row, 0) );
+}
@@ -4,8 +4,10 @@
 #include <chrono>
 #include <QFrame>
 #include <QTableWidgetItem>
-#include <QStandardItemModel>
 #include "bt_editor_base.h"
+#include "replay_log.h"
+#include "replay_table_model.h"
+#include "replay_filter_model.h"
 
 
 namespace Ui {
@@ -24,7 +26,7 @@ public:
 
     void loadLog(const QByteArray& content);
 
-    size_t transitionsCount() const { return _transitions.size(); }
+    size_t transitionsCount() const { return _log.transitionsCount(); }
 
 public slots:
 
@@ -40,12 +42,12 @@ private slots:
 
     void on_tableView_clicked(const QModelIndex &index);
 
-    void onTimerUpdate();
-
     void onPlayUpdate();
 
     void on_lineEditFilter_textChanged(const QString &filter_text);
 
+    void onFilterTimeout();
+
 signals:
     void loadBehaviorTree(const AbsBehaviorTree& tree, const QString& name );
 
@@ -64,31 +66,29 @@ private:
 
     Ui::SidepanelReplay *ui;
 
-    struct Transition{
-        int16_t index;
-        double timestamp;
-        NodeStatus prev_status;
-        NodeStatus status;
-        bool is_tree_restart;
-        int nearest_restart_transition_index;
-    };
-    std::vector<Transition> _transitions;
-    std::vector< std::pair<double,int>> _timepoint;
+    void onLogLoaded(ReplayLog::Result result);
+
+    ReplayLog _log;
 
     int _prev_row;
     int _next_row;
 
     void updatedSpinAndSlider(int row);
 
-    QStandardItemModel* _table_model;
+    ReplayTableModel* _table_model;
+
+    ReplayFilterModel* _filter_model;
+
+    QTimer *_filter_timer;
 
-    QTimer *_layout_update_timer;
+    /// Index of the view showing the given row of the log (invalid if filtered out).
+    QModelIndex viewIndex(int row) const;
 
     QTimer *_play_timer;
 
-    AbsBehaviorTree _loaded_tree;
+    void updateTableModel();
 
-    void updateTableModel(const AbsBehaviorTree &tree);
+    void updateColumnsWidth();
 
     QWidget *_parent;
 };
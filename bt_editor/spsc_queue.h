@@ -0,0 +1,64 @@
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <atomic>
+#include <array>
+#include <cstddef>
+#include <utility>
+
+/// Bounded, lock-free queue for exactly one producer thread and one consumer thread.
+///
+/// Items are exchanged with std::swap instead of being copied: push() hands back
+/// to the producer whatever the slot contained before (typically an already drained
+/// item), so containers keep their capacity and the steady state does not allocate.
+template <typename T, size_t Capacity>
+class SpscQueue
+{
+    static_assert( Capacity >= 2 && (Capacity & (Capacity - 1)) == 0,
+                   "SpscQueue capacity must be a power of two" );
+public:
+
+    SpscQueue(): _head(0), _tail(0) {}
+
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    /// Producer only. Returns false if the queue is full; in that case item is untouched.
+    bool push(T& item)
+    {
+        const size_t head = _head.load(std::memory_order_relaxed);
+        if( head - _tail.load(std::memory_order_acquire) == Capacity )
+        {
+            return false;
+        }
+        std::swap( _slots[head & (Capacity - 1)], item );
+        _head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    /// Consumer only. Returns false if the queue is empty.
+    bool pop(T& item)
+    {
+        const size_t tail = _tail.load(std::memory_order_relaxed);
+        if( tail == _head.load(std::memory_order_acquire) )
+        {
+            return false;
+        }
+        std::swap( _slots[tail & (Capacity - 1)], item );
+        _tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool empty() const
+    {
+        return _tail.load(std::memory_order_acquire) == _head.load(std::memory_order_acquire);
+    }
+
+private:
+    std::array<T, Capacity> _slots;
+    // head and tail are written by different threads: keep them on separate cache lines
+    alignas(64) std::atomic<size_t> _head;
+    alignas(64) std::atomic<size_t> _tail;
+};
+
+#endif // SPSC_QUEUE_H
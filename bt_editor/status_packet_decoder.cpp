@@ -0,0 +1,88 @@
+#include "status_packet_decoder.h"
+#include "utils.h"
+#include <algorithm>
+
+const uint16_t StatusPacketDecoder::INVALID_INDEX;
+
+std::shared_ptr<const StatusPacketDecoder::UidTable>
+StatusPacketDecoder::makeUidTable(const std::unordered_map<int, int> &uid_to_index)
+{
+    auto table = std::make_shared<UidTable>( 0x10000, INVALID_INDEX );
+    for(const auto& it: uid_to_index)
+    {
+        if( it.first >= 0 && it.first < 0x10000 &&
+            it.second >= 0 && it.second < INVALID_INDEX )
+        {
+            (*table)[it.first] = static_cast<uint16_t>(it.second);
+        }
+    }
+    return table;
+}
+
+void StatusPacketDecoder::setUidToIndex(const std::unordered_map<int, int> &uid_to_index)
+{
+    _uid_to_index = makeUidTable( uid_to_index );
+}
+
+StatusPacketDecoder::Result
+StatusPacketDecoder::decode(const char* buffer, size_t size,
+                            std::vector<NodeStatusUpdate>& updates) const
+{
+    updates.clear();
+
+    if( !_uid_to_index )
+    {
+        return UNKNOWN_UID;
+    }
+    const UidTable& uid_to_index = *_uid_to_index;
+
+    // layout of the packet:
+    //   uint32 header_size, then header_size/3 entries [uint16 uid, uint8 status]
+    //   uint32 num_transitions, then num_transitions entries of 12 bytes:
+    //   [uint32 t_sec, uint32 t_usec, uint16 uid, uint8 prev_status, uint8 status]
+    if( size < 8 )
+    {
+        return MALFORMED_PACKET;
+    }
+    const size_t header_size = flatbuffers::ReadScalar<uint32_t>( buffer );
+    if( header_size + 8 > size )
+    {
+        return MALFORMED_PACKET;
+    }
+    const size_t num_transitions = flatbuffers::ReadScalar<uint32_t>( &buffer[4+header_size] );
+    if( num_transitions > (size - 8 - header_size) / 12 )
+    {
+        return MALFORMED_PACKET;
+    }
+
+    updates.reserve( header_size/3 + num_transitions );
+
+    for(size_t offset = 4; offset + 3 <= header_size + 4; offset += 3 )
+    {
+        const uint16_t uid = flatbuffers::ReadScalar<uint16_t>(&buffer[offset]);
+        const uint16_t index = uid_to_index[uid];
+        if( index == INVALID_INDEX )
+        {
+            return UNKNOWN_UID;
+        }
+        const NodeStatus status =
+            convert(flatbuffers::ReadScalar<Serialization::NodeStatus>(&buffer[offset+2] ));
+        updates.push_back( {index, status, false} );
+    }
+
+    for(size_t t=0; t < num_transitions; t++)
+    {
+        const size_t offset = 8 + header_size + 12*t;
+
+        const uint16_t uid = flatbuffers::ReadScalar<uint16_t>(&buffer[offset+8]);
+        const uint16_t index = uid_to_index[uid];
+        if( index == INVALID_INDEX )
+        {
+            return UNKNOWN_UID;
+        }
+        const NodeStatus status =
+            convert(flatbuffers::ReadScalar<Serialization::NodeStatus>(&buffer[offset+11] ));
+        updates.push_back( {index, status, true} );
+    }
+    return SUCCESS;
+}
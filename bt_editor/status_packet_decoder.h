@@ -0,0 +1,59 @@
+#ifndef STATUS_PACKET_DECODER_H
+#define STATUS_PACKET_DECODER_H
+
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <vector>
+#include <unordered_map>
+
+#include "bt_editor_base.h"
+
+/// Status of a single node, identified by its index in the AbsBehaviorTree.
+struct NodeStatusUpdate
+{
+    uint16_t index;
+    NodeStatus status;
+    bool is_transition; // false for the snapshot stored in the header of the packet
+};
+
+/// Decoder of the status packets published by BT::PublisherZMQ.
+///
+/// The packet is validated and decoded in a single pass; UIDs are converted
+/// into node indexes with a dense array (UIDs are 16 bits). The output vector
+/// is reused, therefore decoding does not allocate in the steady state.
+class StatusPacketDecoder
+{
+public:
+    enum Result { SUCCESS, MALFORMED_PACKET, UNKNOWN_UID };
+
+    /// Node index of each UID, INVALID_INDEX if the UID is not in the tree.
+    typedef std::vector<uint16_t> UidTable;
+
+    static const uint16_t INVALID_INDEX = 0xFFFF;
+
+    /// The table is never modified once built: it can be shared with the
+    /// decoders of other threads.
+    static std::shared_ptr<const UidTable> makeUidTable(const std::unordered_map<int, int>& uid_to_index);
+
+    StatusPacketDecoder() {}
+
+    void setUidToIndex(const std::unordered_map<int, int>& uid_to_index);
+
+    void setUidTable(std::shared_ptr<const UidTable> table) { _uid_to_index = std::move(table); }
+
+    const std::shared_ptr<const UidTable>& uidTable() const { return _uid_to_index; }
+
+    /// Without a table, every UID is unknown.
+    void clear() { _uid_to_index.reset(); }
+
+    /// updates is cleared and filled with the header first, then the transitions.
+    /// On failure its content is unspecified.
+    Result decode(const char* buffer, size_t size,
+                  std::vector<NodeStatusUpdate>& updates) const;
+
+private:
+    std::shared_ptr<const UidTable> _uid_to_index;
+};
+
+#endif // STATUS_PACKET_DECODER_H
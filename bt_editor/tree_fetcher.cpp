@@ -0,0 +1,107 @@
+#include "tree_fetcher.h"
+#include <QDebug>
+#include <algorithm>
+#include <chrono>
+
+TreeFetcher::TreeFetcher(zmq::context_t &context, QObject *parent) :
+    QObject(parent),
+    _zmq_context(context),
+    _cancel_requested(false),
+    _request_id(0),
+    _busy(false)
+{
+    connect( this, &TreeFetcher::requestDone,
+             this, &TreeFetcher::onRequestDone, Qt::QueuedConnection );
+}
+
+TreeFetcher::~TreeFetcher()
+{
+    cancel();
+}
+
+void TreeFetcher::request(const std::string &address, int timeout_ms)
+{
+    cancel();
+
+    _cancel_requested = false;
+    _busy = true;
+    _thread = std::thread( &TreeFetcher::requestLoop, this, address, timeout_ms, _request_id );
+}
+
+void TreeFetcher::cancel()
+{
+    if( _thread.joinable() )
+    {
+        _cancel_requested = true;
+        _thread.join();
+    }
+    // results of the previous request, already queued, will be ignored
+    _request_id++;
+    _busy = false;
+}
+
+void TreeFetcher::onRequestDone(unsigned request_id, bool success, const QByteArray &reply)
+{
+    if( request_id != _request_id )
+    {
+        return;
+    }
+    if( _thread.joinable() )
+    {
+        _thread.join();
+    }
+    _busy = false;
+
+    if( success )
+    {
+        emit replyReceived( reply );
+    }
+    else{
+        emit requestFailed();
+    }
+}
+
+void TreeFetcher::requestLoop(std::string address, int timeout_ms, unsigned request_id)
+{
+    // the receive is split in short slices, to react quickly to cancel()
+    const int slice_ms = std::min( timeout_ms, 50 );
+    const auto deadline = std::chrono::steady_clock::now() +
+                          std::chrono::milliseconds(timeout_ms);
+    try{
+        zmq::message_t request(0);
+        zmq::message_t reply;
+
+        zmq::socket_t zmq_client( _zmq_context, ZMQ_REQ );
+        zmq_client.set(zmq::sockopt::rcvtimeo, slice_ms);
+        zmq_client.set(zmq::sockopt::linger, 0);
+        zmq_client.connect( address.c_str() );
+
+        zmq_client.send(request, zmq::send_flags::none);
+
+        while( !_cancel_requested )
+        {
+            auto bytes_received = zmq_client.recv(reply, zmq::recv_flags::none);
+            if( bytes_received )
+            {
+                const bool success = ( *bytes_received > 0 );
+                emit requestDone( request_id, success,
+                                  QByteArray( reinterpret_cast<const char*>(reply.data()),
+                                              static_cast<int>(reply.size()) ) );
+                return;
+            }
+            if( std::chrono::steady_clock::now() >= deadline )
+            {
+                break;
+            }
+        }
+    }
+    catch( zmq::error_t& err)
+    {
+        qDebug() << "ZMQ client receive failed: " << err.what();
+    }
+
+    if( !_cancel_requested )
+    {
+        emit requestDone( request_id, false, QByteArray() );
+    }
+}
@@ -0,0 +1,52 @@
+#ifndef TREE_FETCHER_H
+#define TREE_FETCHER_H
+
+#include <QObject>
+#include <QByteArray>
+#include <atomic>
+#include <thread>
+#include <string>
+#include <zmq.hpp>
+
+/// Asks the tree to the BT::PublisherZMQ server (ZMQ_REQ/ZMQ_REP) without
+/// blocking the GUI thread: the request is executed on a dedicated thread and
+/// the outcome is notified with replyReceived() or requestFailed().
+class TreeFetcher : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit TreeFetcher(zmq::context_t& context, QObject *parent = nullptr);
+    ~TreeFetcher() override;
+
+    /// Send a new request, abandoning the previous one (if any).
+    void request(const std::string& address, int timeout_ms);
+
+    /// Abandon the current request. No signal will be emitted for it.
+    void cancel();
+
+    bool isBusy() const { return _busy; }
+
+signals:
+    void replyReceived(const QByteArray& reply);
+
+    void requestFailed();
+
+    // used internally to move the result to the GUI thread
+    void requestDone(unsigned request_id, bool success, const QByteArray& reply);
+
+private slots:
+    void onRequestDone(unsigned request_id, bool success, const QByteArray& reply);
+
+private:
+    void requestLoop(std::string address, int timeout_ms, unsigned request_id);
+
+    zmq::context_t& _zmq_context;
+
+    std::thread _thread;
+    std::atomic<bool> _cancel_requested;
+    unsigned _request_id;
+    bool _busy;
+};
+
+#endif // TREE_FETCHER_H
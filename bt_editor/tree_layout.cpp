@@ -0,0 +1,594 @@
+#include "tree_layout.h"
+#include <algorithm>
+#include <deque>
+#include <vector>
+
+using QtNodes::PortLayout;
+
+namespace
+{
+
+const qreal LEVEL_SPACING = 80;
+const qreal NODE_SPACING  = 40;
+
+const int NONE = -1;
+
+// Data of the algorithm, indexed like AbsBehaviorTree::nodes().
+// The coordinate is the center of the node, along the direction of the siblings.
+struct LayoutNode
+{
+    int parent;
+    int number;   // position among the siblings
+    int first_child;
+    int last_child;
+    int thread;
+    int ancestor;
+    qreal half_size;
+    qreal prelim;
+    qreal mod;
+    qreal shift;
+    qreal change;
+};
+
+class TidyLayout
+{
+public:
+    TidyLayout(const AbsBehaviorTree& tree, PortLayout layout);
+
+    // Lays out the subtree of root and returns the center of each of its nodes
+    const std::vector<qreal>& run(int root);
+
+private:
+    int leftSibling(int v) const
+    {
+        const auto& node = _nodes[v];
+        return (node.parent == NONE || node.number == 0) ? NONE :
+                   _children[_nodes[node.parent].first_child + node.number - 1];
+    }
+
+    int nextLeft(int v) const
+    {
+        return (_nodes[v].first_child != _nodes[v].last_child) ?
+                   _children[_nodes[v].first_child] : _nodes[v].thread;
+    }
+
+    int nextRight(int v) const
+    {
+        return (_nodes[v].first_child != _nodes[v].last_child) ?
+                   _children[_nodes[v].last_child - 1] : _nodes[v].thread;
+    }
+
+    qreal separation(int left, int right) const
+    {
+        return _nodes[left].half_size + _nodes[right].half_size + NODE_SPACING;
+    }
+
+    void firstWalk(int v);
+
+    void apportion(int v, int& default_ancestor);
+
+    void moveSubtree(int left, int right, qreal shift);
+
+    void executeShifts(int v);
+
+    std::vector<LayoutNode> _nodes;
+    std::vector<int> _children;   // the children of node v are in [first_child, last_child)
+    std::vector<int> _preorder;
+    std::vector<qreal> _center;
+};
+
+TidyLayout::TidyLayout(const AbsBehaviorTree &tree, PortLayout layout)
+{
+    const auto& tree_nodes = tree.nodes();
+    const bool vertical = (layout == PortLayout::Vertical);
+
+    _nodes.resize( tree_nodes.size() );
+    _children.reserve( tree_nodes.size() );
+    for (size_t i = 0; i < tree_nodes.size(); i++)
+    {
+        const auto& tree_node = tree_nodes[i];
+        LayoutNode& node = _nodes[i];
+        node.parent = NONE;
+        node.number = 0;
+        node.first_child = int(_children.size());
+        for (int child: tree_node.children_index)
+        {
+            _children.push_back( child );
+        }
+        node.last_child = int(_children.size());
+        node.thread = NONE;
+        node.ancestor = int(i);
+        node.half_size = 0.5 * (vertical ? tree_node.size.width() : tree_node.size.height());
+        node.prelim = 0;
+        node.mod = 0;
+        node.shift = 0;
+        node.change = 0;
+    }
+    for (size_t i = 0; i < tree_nodes.size(); i++)
+    {
+        for (int c = _nodes[i].first_child; c < _nodes[i].last_child; c++)
+        {
+            _nodes[ _children[c] ].parent = int(i);
+            _nodes[ _children[c] ].number = c - _nodes[i].first_child;
+        }
+    }
+}
+
+const std::vector<qreal>& TidyLayout::run(int root)
+{
+    // the tree can be too deep for a recursion: visit it with a stack
+    _preorder.reserve( _nodes.size() );
+    std::vector<int> stack( 1, root );
+    while( !stack.empty() )
+    {
+        const int v = stack.back();
+        stack.pop_back();
+        _preorder.push_back( v );
+        for (int c = _nodes[v].last_child; c > _nodes[v].first_child; c--)
+        {
+            stack.push_back( _children[c-1] );
+        }
+    }
+
+    // the children of a node are always visited before it
+    for (auto it = _preorder.rbegin(); it != _preorder.rend(); it++)
+    {
+        firstWalk( *it );
+    }
+
+    // second walk: add the modifiers of the ancestors
+    _center.assign( _nodes.size(), 0 );
+    std::vector<qreal> mod_sum( _nodes.size(), 0 );
+    for (int v: _preorder)
+    {
+        _center[v] = _nodes[v].prelim + mod_sum[v];
+        for (int c = _nodes[v].first_child; c < _nodes[v].last_child; c++)
+        {
+            mod_sum[ _children[c] ] = mod_sum[v] + _nodes[v].mod;
+        }
+    }
+    return _center;
+}
+
+// Called when the subtrees of the children of v are already laid out, each one
+// as if it had no left sibling: they are placed one next to the other here,
+// which is what firstWalk() does in the paper after the recursion.
+void TidyLayout::firstWalk(int v)
+{
+    LayoutNode& node = _nodes[v];
+    if( node.first_child == node.last_child )
+    {
+        return;
+    }
+
+    int default_ancestor = _children[node.first_child];
+    for (int c = node.first_child; c < node.last_child; c++)
+    {
+        const int w = _children[c];
+        const int left = leftSibling( w );
+        if( left != NONE )
+        {
+            const qreal prelim = _nodes[left].prelim + separation( left, w );
+            if( _nodes[w].first_child != _nodes[w].last_child )
+            {
+                _nodes[w].mod = prelim - _nodes[w].prelim;
+            }
+            _nodes[w].prelim = prelim;
+        }
+        apportion( w, default_ancestor );
+    }
+    executeShifts( v );
+
+    const qreal first = _nodes[ _children[node.first_child] ].prelim;
+    const qreal last  = _nodes[ _children[node.last_child - 1] ].prelim;
+    node.prelim = (first + last) * 0.5;
+}
+
+void TidyLayout::apportion(int v, int& default_ancestor)
+{
+    const int w = leftSibling( v );
+    if( w == NONE )
+    {
+        return;
+    }
+    const int parent = _nodes[v].parent;
+
+    // inside (i) and outside (o) contours, of the right (p) and left (m) subtrees
+    int vip = v;
+    int vop = v;
+    int vim = w;
+    int vom = _children[ _nodes[parent].first_child ];
+    qreal sip = _nodes[vip].mod;
+    qreal sop = _nodes[vop].mod;
+    qreal sim = _nodes[vim].mod;
+    qreal som = _nodes[vom].mod;
+
+    while( nextRight( vim ) != NONE && nextLeft( vip ) != NONE )
+    {
+        vim = nextRight( vim );
+        vip = nextLeft( vip );
+        vom = nextLeft( vom );
+        vop = nextRight( vop );
+        _nodes[vop].ancestor = v;
+
+        const qreal shift = (_nodes[vim].prelim + sim) - (_nodes[vip].prelim + sip)
+                            + separation( vim, vip );
+        if( shift > 0 )
+        {
+            const int ancestor = _nodes[ _nodes[vim].ancestor ].parent == parent ?
+                                     _nodes[vim].ancestor : default_ancestor;
+            moveSubtree( ancestor, v, shift );
+            sip += shift;
+            sop += shift;
+        }
+        sim += _nodes[vim].mod;
+        sip += _nodes[vip].mod;
+        som += _nodes[vom].mod;
+        sop += _nodes[vop].mod;
+    }
+
+    if( nextRight( vim ) != NONE && nextRight( vop ) == NONE )
+    {
+        _nodes[vop].thread = nextRight( vim );
+        _nodes[vop].mod += sim - sop;
+    }
+    if( nextLeft( vip ) != NONE && nextLeft( vom ) == NONE )
+    {
+        _nodes[vom].thread = nextLeft( vip );
+        _nodes[vom].mod += sip - som;
+        default_ancestor = v;
+    }
+}
+
+void TidyLayout::moveSubtree(int left, int right, qreal shift)
+{
+    const qreal subtrees = _nodes[right].number - _nodes[left].number;
+    _nodes[right].change -= shift / subtrees;
+    _nodes[right].shift  += shift;
+    _nodes[left].change  += shift / subtrees;
+    _nodes[right].prelim += shift;
+    _nodes[right].mod    += shift;
+}
+
+void TidyLayout::executeShifts(int v)
+{
+    qreal shift = 0;
+    qreal change = 0;
+    for (int c = _nodes[v].last_child; c > _nodes[v].first_child; c--)
+    {
+        LayoutNode& w = _nodes[ _children[c-1] ];
+        w.prelim += shift;
+        w.mod    += shift;
+        change   += w.change;
+        shift    += w.shift + change;
+    }
+}
+
+// Extent of a group of nodes along the siblings and across the levels, for each
+// level. After a partial layout, a node may be larger than the band of its level
+// and reach the next ones: the extent across the levels is what is compared.
+struct Contour
+{
+    Contour(): first_level(0) {}
+
+    void add(int level, qreal node_begin, qreal node_end, qreal node_top, qreal node_bottom)
+    {
+        if( begin.empty() )
+        {
+            first_level = level;
+        }
+        while( level < first_level )
+        {
+            begin.push_front( node_begin );
+            end.push_front( node_end );
+            top.push_front( node_top );
+            bottom.push_front( node_bottom );
+            first_level--;
+        }
+        while( level >= first_level + int(begin.size()) )
+        {
+            begin.push_back( node_begin );
+            end.push_back( node_end );
+            top.push_back( node_top );
+            bottom.push_back( node_bottom );
+        }
+        const int i = level - first_level;
+        begin[i]  = std::min( begin[i], node_begin );
+        end[i]    = std::max( end[i], node_end );
+        top[i]    = std::min( top[i], node_top );
+        bottom[i] = std::max( bottom[i], node_bottom );
+    }
+
+    void translate(qreal offset)
+    {
+        for (size_t i = 0; i < begin.size(); i++)
+        {
+            begin[i] += offset;
+            end[i] += offset;
+        }
+    }
+
+    void merge(const Contour& other)
+    {
+        for (size_t i = 0; i < other.begin.size(); i++)
+        {
+            add( other.first_level + int(i), other.begin[i], other.end[i],
+                 other.top[i], other.bottom[i] );
+        }
+    }
+
+    // How much right must be moved forward to be at NODE_SPACING from left,
+    // comparing the levels that are at the same depth
+    static qreal overlap(const Contour& left, const Contour& right)
+    {
+        qreal overlap = 0;
+        for (size_t i = 0; i < right.begin.size(); i++)
+        {
+            for (size_t j = 0; j < left.begin.size(); j++)
+            {
+                const bool same_level = ( right.first_level + int(i) == left.first_level + int(j) );
+                if( same_level || (right.top[i] < left.bottom[j] && left.top[j] < right.bottom[i]) )
+                {
+                    const qreal distance = right.begin[i] - left.end[j];
+                    overlap = std::max( overlap, NODE_SPACING - distance );
+                }
+            }
+        }
+        return overlap;
+    }
+
+    int first_level;
+    std::deque<qreal> begin;
+    std::deque<qreal> end;
+    std::deque<qreal> top;
+    std::deque<qreal> bottom;
+};
+
+std::vector<int> SubtreeNodes(const AbsBehaviorTree& tree, int root)
+{
+    std::vector<int> nodes;
+    std::vector<int> stack( 1, root );
+    while( !stack.empty() )
+    {
+        const int v = stack.back();
+        stack.pop_back();
+        nodes.push_back( v );
+        const auto& children = tree.nodes()[v].children_index;
+        stack.insert( stack.end(), children.rbegin(), children.rend() );
+    }
+    return nodes;
+}
+
+qreal AlongSiblings(const QPointF& point, bool vertical)
+{
+    return vertical ? point.x() : point.y();
+}
+
+qreal AlongSiblings(const QSizeF& size, bool vertical)
+{
+    return vertical ? size.width() : size.height();
+}
+
+qreal AcrossLevels(const QPointF& point, bool vertical)
+{
+    return vertical ? point.y() : point.x();
+}
+
+qreal AcrossLevels(const QSizeF& size, bool vertical)
+{
+    return vertical ? size.height() : size.width();
+}
+
+Contour SubtreeContour(const AbsBehaviorTree& tree, int root, const std::vector<int>& level,
+                       bool vertical)
+{
+    Contour contour;
+    for (int v: SubtreeNodes( tree, root ))
+    {
+        const auto& node = tree.nodes()[v];
+        const qreal begin = AlongSiblings( node.pos, vertical );
+        const qreal top = AcrossLevels( node.pos, vertical );
+        contour.add( level[v], begin, begin + AlongSiblings( node.size, vertical ),
+                     top, top + AcrossLevels( node.size, vertical ) );
+    }
+    return contour;
+}
+
+void MoveSubtree(AbsBehaviorTree& tree, int root, qreal offset, bool vertical)
+{
+    const QPointF delta = vertical ? QPointF( offset, 0 ) : QPointF( 0, offset );
+    for (int v: SubtreeNodes( tree, root ))
+    {
+        tree.nodes()[v].pos += delta;
+    }
+}
+
+} // end namespace
+
+
+void TidyTreeLayout(AbsBehaviorTree& tree, PortLayout layout)
+{
+    if( tree.nodesCount() == 0 )
+    {
+        return;
+    }
+    const bool vertical = (layout == PortLayout::Vertical);
+
+    TidyLayout tidy_layout( tree, layout );
+    const std::vector<qreal>& center = tidy_layout.run( 0 );
+    auto& nodes = tree.nodes();
+    const qreal origin = center[0];
+
+    // levels, visited breadth first
+    std::vector<int> level( nodes.size(), 0 );
+    std::vector<qreal> level_size( 1, 0 );
+    std::vector<int> queue( 1, 0 );
+    queue.reserve( nodes.size() );
+    for (size_t q = 0; q < queue.size(); q++)
+    {
+        const int v = queue[q];
+        const auto& node = nodes[v];
+        if( level[v] >= int(level_size.size()) )
+        {
+            level_size.push_back( 0 );
+        }
+        level_size[ level[v] ] = std::max( level_size[ level[v] ],
+                                           vertical ? node.size.height() : node.size.width() );
+        for (int child: node.children_index)
+        {
+            level[child] = level[v] + 1;
+            queue.push_back( child );
+        }
+    }
+
+    // the first level starts after the whole root, as the root is centered on the origin
+    std::vector<qreal> level_offset( level_size.size(), 0 );
+    level_offset[0] = -level_size[0] * 0.5;
+    qreal offset = level_size[0] + LEVEL_SPACING;
+    for (size_t i = 1; i < level_size.size(); i++)
+    {
+        level_offset[i] = offset;
+        offset += level_size[i] + LEVEL_SPACING;
+    }
+
+    for (int v: queue)
+    {
+        auto& node = nodes[v];
+        if( vertical )
+        {
+            node.pos = QPointF( center[v] - origin - node.size.width() * 0.5,
+                                level_offset[ level[v] ] );
+        }
+        else{
+            node.pos = QPointF( level_offset[ level[v] ],
+                                center[v] - origin - node.size.height() * 0.5 );
+        }
+    }
+}
+
+void TidySubtreeLayout(AbsBehaviorTree& tree, int subtree_root, PortLayout layout)
+{
+    if( subtree_root == 0 )
+    {
+        TidyTreeLayout( tree, layout );
+        return;
+    }
+    const bool vertical = (layout == PortLayout::Vertical);
+    auto& nodes = tree.nodes();
+
+    std::vector<int> level( nodes.size(), 0 );
+    std::vector<int> parent( nodes.size(), -1 );
+    for (size_t v = 0; v < nodes.size(); v++)
+    {
+        for (int child: nodes[v].children_index)
+        {
+            parent[child] = int(v);
+        }
+    }
+    const std::vector<int> preorder = SubtreeNodes( tree, 0 );
+    for (int v: preorder)
+    {
+        if( parent[v] >= 0 )
+        {
+            level[v] = level[ parent[v] ] + 1;
+        }
+    }
+
+    // the nodes of the subtree are aligned to the other nodes of their level, if
+    // they are far enough from the previous level
+    const std::vector<int> subtree = SubtreeNodes( tree, subtree_root );
+    std::vector<bool> in_subtree( nodes.size(), false );
+    for (int v: subtree)
+    {
+        in_subtree[v] = true;
+    }
+    const int root_level = level[subtree_root];
+    int subtree_levels = 1;
+    for (int v: subtree)
+    {
+        subtree_levels = std::max( subtree_levels, level[v] - root_level + 1 );
+    }
+    std::vector<qreal> level_size( subtree_levels, 0 );
+    for (int v: subtree)
+    {
+        qreal& size = level_size[ level[v] - root_level ];
+        size = std::max( size, AcrossLevels( nodes[v].size, vertical ) );
+    }
+    std::vector<qreal> level_offset( subtree_levels, 0 );
+    std::vector<bool> aligned( subtree_levels, false );
+    for (int v: preorder)
+    {
+        const int i = level[v] - root_level;
+        if( !in_subtree[v] && i > 0 && i < subtree_levels && !aligned[i] )
+        {
+            level_offset[i] = AcrossLevels( nodes[v].pos, vertical );
+            aligned[i] = true;
+        }
+    }
+    level_offset[0] = AcrossLevels( nodes[subtree_root].pos, vertical );
+    for (int i = 1; i < subtree_levels; i++)
+    {
+        const qreal offset = level_offset[i-1] + level_size[i-1] + LEVEL_SPACING;
+        level_offset[i] = aligned[i] ? std::max( level_offset[i], offset ) : offset;
+    }
+
+    // the root of the subtree keeps its position
+    TidyLayout tidy_layout( tree, layout );
+    const std::vector<qreal>& center = tidy_layout.run( subtree_root );
+    const auto& root = nodes[subtree_root];
+    const qreal origin = center[subtree_root] -
+            AlongSiblings( root.pos, vertical ) - AlongSiblings( root.size, vertical ) * 0.5;
+
+    Contour contour;
+    for (int v: subtree)
+    {
+        auto& node = nodes[v];
+        const qreal begin = center[v] - origin - AlongSiblings( node.size, vertical ) * 0.5;
+        const qreal depth = level_offset[ level[v] - root_level ];
+        node.pos = vertical ? QPointF( begin, depth ) : QPointF( depth, begin );
+        contour.add( level[v], begin, begin + AlongSiblings( node.size, vertical ),
+                     depth, depth + AcrossLevels( node.size, vertical ) );
+    }
+
+    // push away the siblings of the subtree and of its ancestors, where they
+    // overlap; the rest of the tree does not move
+    for (int child = subtree_root; parent[child] >= 0; child = parent[child])
+    {
+        const auto& siblings = nodes[ parent[child] ].children_index;
+        const int position = int( std::find( siblings.begin(), siblings.end(), child ) - siblings.begin() );
+
+        Contour forward = contour;
+        for (int i = position + 1; i < int(siblings.size()); i++)
+        {
+            Contour sibling = SubtreeContour( tree, siblings[i], level, vertical );
+            const qreal overlap = Contour::overlap( forward, sibling );
+            if( overlap > 0 )
+            {
+                MoveSubtree( tree, siblings[i], overlap, vertical );
+                sibling.translate( overlap );
+            }
+            forward.merge( sibling );
+        }
+
+        Contour backward = contour;
+        for (int i = position - 1; i >= 0; i--)
+        {
+            Contour sibling = SubtreeContour( tree, siblings[i], level, vertical );
+            const qreal overlap = Contour::overlap( sibling, backward );
+            if( overlap > 0 )
+            {
+                MoveSubtree( tree, siblings[i], -overlap, vertical );
+                sibling.translate( -overlap );
+            }
+            backward.merge( sibling );
+        }
+
+        contour = forward;
+        contour.merge( backward );
+        const auto& parent_node = nodes[ parent[child] ];
+        const qreal begin = AlongSiblings( parent_node.pos, vertical );
+        const qreal top = AcrossLevels( parent_node.pos, vertical );
+        contour.add( level[ parent[child] ], begin, begin + AlongSiblings( parent_node.size, vertical ),
+                     top, top + AcrossLevels( parent_node.size, vertical ) );
+    }
+}
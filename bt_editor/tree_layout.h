@@ -0,0 +1,27 @@
+#ifndef TREE_LAYOUT_H
+#define TREE_LAYOUT_H
+
+#include <nodes/internal/PortType.hpp>
+
+#include "bt_editor_base.h"
+
+/// Tidy tree layout (Reingold-Tilford), in the linear time version of
+/// Buchheim, Junger and Leipert, "Improving Walker's algorithm to run in linear time".
+///
+/// Sets AbstractTreeNode::pos of every node of the tree, using AbstractTreeNode::size:
+/// - the subtrees are packed as close as their contours allow, level by level;
+/// - a parent is centered on its first and last child;
+/// - the nodes of the same level are aligned, the distance between two levels
+///   depends on the largest node of the first one.
+/// With PortLayout::Vertical the levels go from top to bottom, otherwise from left to right.
+/// The center of the root is at the origin.
+void TidyTreeLayout(AbsBehaviorTree& tree, QtNodes::PortLayout layout);
+
+/// Lays out again only the subtree of the node with index subtree_root, after
+/// an edit: AbstractTreeNode::pos must contain the current positions.
+/// The root of the subtree does not move, and the siblings of the subtree and
+/// of its ancestors are pushed away only if they overlap with it; the rest of
+/// the tree keeps its position.
+void TidySubtreeLayout(AbsBehaviorTree& tree, int subtree_root, QtNodes::PortLayout layout);
+
+#endif // TREE_LAYOUT_H
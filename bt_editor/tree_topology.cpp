@@ -0,0 +1,155 @@
+#include "tree_topology.h"
+#include <algorithm>
+#include <numeric>
+
+using namespace QtNodes;
+
+TreeTopology::TreeTopology(FlowScene &scene):
+    QObject(&scene),
+    _scene(scene)
+{
+    connect( &scene, &FlowScene::nodeCreated, this, &TreeTopology::onNodeCreated );
+    connect( &scene, &FlowScene::nodeDeleted, this, &TreeTopology::onNodeDeleted );
+    connect( &scene, &FlowScene::connectionCreated, this, &TreeTopology::onConnectionCreated );
+    connect( &scene, &FlowScene::connectionDeleted, this,
+             [this](Connection& connection) { removeEdge( &connection ); } );
+
+    for (const auto& it: scene.nodes())
+    {
+        onNodeCreated( *it.second );
+    }
+    for (const auto& it: scene.connections())
+    {
+        onConnectionCreated( *it.second );
+    }
+}
+
+Node *TreeTopology::root() const
+{
+    return (_orphans.size() == 1) ? *_orphans.begin() : nullptr;
+}
+
+Node *TreeTopology::parent(const Node &node) const
+{
+    auto it = _links.find( &node );
+    return (it != _links.end()) ? it->second.parent : nullptr;
+}
+
+std::vector<Node *> TreeTopology::children(const Node &node, bool ordered) const
+{
+    auto it = _links.find( &node );
+    if( it == _links.end() )
+    {
+        return {};
+    }
+    if( ordered && it->second.children.size() > 1 )
+    {
+        sortChildren( it->second );
+    }
+    return it->second.children;
+}
+
+void TreeTopology::onNodeCreated(Node &node)
+{
+    _links[&node];
+    _orphans.insert( &node );
+}
+
+void TreeTopology::onNodeDeleted(Node &node)
+{
+    // FlowScene::removeNode() deletes the connections of the node after this
+    // signal: the edges are removed then.
+    _links.erase( &node );
+    _orphans.erase( &node );
+}
+
+void TreeTopology::onConnectionCreated(Connection &connection)
+{
+    Node* parent = connection.getNode( PortType::Out );
+    Node* child  = connection.getNode( PortType::In );
+    if( !parent || !child ||
+        connection.getPortIndex( PortType::Out ) != 0 ||
+        connection.getPortIndex( PortType::In ) != 0 )
+    {
+        return;
+    }
+
+    // the same connection may be notified more than once, or moved to another port
+    auto edge_it = _edges.find( &connection );
+    if( edge_it != _edges.end() )
+    {
+        if( edge_it->second.parent == parent && edge_it->second.child == child )
+        {
+            return;
+        }
+        removeEdge( &connection );
+    }
+
+    auto parent_it = _links.find( parent );
+    auto child_it  = _links.find( child );
+    if( parent_it == _links.end() || child_it == _links.end() )
+    {
+        return;
+    }
+    _edges[&connection] = { parent, child };
+    parent_it->second.children.push_back( child );
+    child_it->second.parent = parent;
+    _orphans.erase( child );
+}
+
+void TreeTopology::removeEdge(const Connection *connection)
+{
+    auto edge_it = _edges.find( connection );
+    if( edge_it == _edges.end() )
+    {
+        return;
+    }
+    const Edge edge = edge_it->second;
+    _edges.erase( edge_it );
+
+    auto parent_it = _links.find( edge.parent );
+    if( parent_it != _links.end() )
+    {
+        auto& children = parent_it->second.children;
+        children.erase( std::remove( children.begin(), children.end(), edge.child ),
+                        children.end() );
+    }
+    auto child_it = _links.find( edge.child );
+    if( child_it != _links.end() && child_it->second.parent == edge.parent )
+    {
+        child_it->second.parent = nullptr;
+        _orphans.insert( edge.child );
+    }
+}
+
+void TreeTopology::sortChildren(Links &links) const
+{
+    auto& children = links.children;
+    const bool vertical = ( _scene.layout() == PortLayout::Vertical );
+
+    // position of the center, along the direction of the siblings
+    std::vector<double> keys( children.size() );
+    for (size_t i = 0; i < children.size(); i++)
+    {
+        const QPointF pos = _scene.getNodePosition( *children[i] );
+        const QSizeF size = _scene.getNodeSize( *children[i] );
+        keys[i] = vertical ? (pos.x() + size.width()*0.5) : (pos.y() + size.height()*0.5);
+    }
+    if( std::is_sorted( keys.begin(), keys.end() ) )
+    {
+        return;
+    }
+
+    std::vector<size_t> order( children.size() );
+    std::iota( order.begin(), order.end(), 0 );
+    std::stable_sort( order.begin(), order.end(),
+                      [&keys](size_t a, size_t b) { return keys[a] < keys[b]; } );
+
+    std::vector<Node*> sorted;
+    sorted.reserve( children.size() );
+    for (size_t index: order)
+    {
+        sorted.push_back( children[index] );
+    }
+    children.swap( sorted );
+}
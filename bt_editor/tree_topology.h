@@ -0,0 +1,63 @@
+#ifndef TREE_TOPOLOGY_H
+#define TREE_TOPOLOGY_H
+
+#include <QObject>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include <nodes/FlowScene>
+#include <nodes/Node>
+#include <nodes/Connection>
+
+/// Parent, children and root of the nodes of a scene, updated by the signals
+/// FlowScene::nodeCreated/nodeDeleted/connectionCreated/connectionDeleted,
+/// instead of visiting the connections of the NodeState every time.
+/// Only the port 0 of each side is used, as in any BehaviorTree node.
+class TreeTopology : public QObject
+{
+public:
+    explicit TreeTopology(QtNodes::FlowScene& scene);
+
+    /// The only node without a parent, nullptr if there are none or more than one.
+    QtNodes::Node* root() const;
+
+    QtNodes::Node* parent(const QtNodes::Node& node) const;
+
+    /// If ordered, the children are sorted by their position (left to right or
+    /// top to bottom, depending on the layout). Nodes can be moved without any
+    /// notification (FlowScene::setNodePosition), therefore the order is checked
+    /// every time, but they are sorted again only when it changed.
+    std::vector<QtNodes::Node*> children(const QtNodes::Node& node, bool ordered) const;
+
+private:
+    struct Links
+    {
+        Links(): parent(nullptr) {}
+        QtNodes::Node* parent;
+        std::vector<QtNodes::Node*> children;
+    };
+
+    struct Edge
+    {
+        QtNodes::Node* parent;
+        QtNodes::Node* child;
+    };
+
+    void onNodeCreated(QtNodes::Node& node);
+
+    void onNodeDeleted(QtNodes::Node& node);
+
+    void onConnectionCreated(QtNodes::Connection& connection);
+
+    void removeEdge(const QtNodes::Connection* connection);
+
+    void sortChildren(Links& links) const;
+
+    QtNodes::FlowScene& _scene;
+    mutable std::unordered_map<const QtNodes::Node*, Links> _links;
+    std::unordered_map<const QtNodes::Connection*, Edge> _edges;
+    std::unordered_set<QtNodes::Node*> _orphans; // nodes without a parent
+};
+
+#endif // TREE_TOPOLOGY_H
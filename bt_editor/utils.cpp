@@ -7,20 +7,40 @@
 #include "nodes/DataModelRegistry"
 #include "nodes/internal/memory.hpp"
 #include "nodes/internal/ConnectionGraphicsObject.hpp"
+#include "nodes/internal/NodeGraphicsObject.hpp"
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QFile>
 #include "models/SubtreeNodeModel.hpp"
 #include "models/RootNodeModel.hpp"
 #include "models/BehaviorTreeNodeModel.hpp"
+#include "editor_flowscene.h"
+#include "tree_layout.h"
 
 using QtNodes::PortLayout;
 using QtNodes::DataModelRegistry;
 using QtNodes::Node;
 using QtNodes::FlowScene;
 
+namespace {
+
+// The scenes of the editor keep track of their topology; this is nullptr
+// for any other FlowScene.
+const TreeTopology* GetTopology(const QGraphicsScene* scene)
+{
+    auto editor_scene = dynamic_cast<const EditorFlowScene*>( scene );
+    return editor_scene ? &editor_scene->topology() : nullptr;
+}
+
+}
+
 QtNodes::Node* findRoot(const QtNodes::FlowScene &scene)
 {
+    if( auto topology = GetTopology( &scene ) )
+    {
+        return topology->root();
+    }
+
     Node* root = nullptr;
 
     for (auto& it: scene.nodes() )
@@ -44,6 +64,11 @@ std::vector<Node*> getChildren(const QtNodes::FlowScene &scene,
                                const Node& parent_node,
                                bool ordered)
 {
+    if( auto topology = GetTopology( &scene ) )
+    {
+        return topology->children( parent_node, ordered );
+    }
+
     std::vector<Node*> children;
 
     if( parent_node.nodeDataModel()->nPorts(PortType::Out) == 0)
@@ -260,180 +285,79 @@ void RestoreVisibilityRespectingCollapsed(FlowScene &scene, Node &root_node)
     rec(root_node);
 }
 
-void RecursiveNodeReorder(AbsBehaviorTree& tree, PortLayout layout)
+void NodeReorder(QtNodes::FlowScene &scene, AbsBehaviorTree & tree)
 {
-    std::function<void(unsigned, AbstractTreeNode*)> recursiveStep;
-
-    std::vector<QPointF> layer_cursor;
-    std::vector< std::vector<AbstractTreeNode*> > nodes_by_level(1);
-
-    const qreal LEVEL_SPACING = 80;
-    const qreal NODE_SPACING  = 40;
 
-    recursiveStep = [&](unsigned current_layer, AbstractTreeNode* node)
+    for (const auto& abs_node: tree.nodes())
     {
-        node->pos = layer_cursor[current_layer];
-        nodes_by_level[current_layer].push_back( node );
-
-        //------------------------------------
-        if( node->children_index.size() == 0 )
-        {
-            return;
-        }
-        qreal recommended_pos = NODE_SPACING * 0.5;
-
-        current_layer++;
-
-        if( layout == PortLayout::Vertical)
-        {
-            recommended_pos += (node->pos.x() + node->size.width()*0.5)  ;
-            for(int index: node->children_index)
-            {
-                const auto& child_node = tree.nodes()[index];
-                recommended_pos -=  (child_node.size.width() + NODE_SPACING) * 0.5;
-            }
-
-            if( current_layer >= layer_cursor.size())
-            {
-                QPointF new_cursor( recommended_pos,
-                                    node->pos.y() + LEVEL_SPACING );
-                layer_cursor.push_back( new_cursor );
-                nodes_by_level.push_back( std::vector<AbstractTreeNode*>() );
-            }
-            else{
-                recommended_pos = std::max( recommended_pos, layer_cursor[current_layer].x() );
-                layer_cursor[current_layer].setX(recommended_pos);
-            }
-        }//------------------------------------
-        else
-        {
-            recommended_pos += node->pos.y() + node->size.height()*0.5;
-            for(int index: node->children_index)
-            {
-                const auto& child_node = tree.nodes()[index];
-                recommended_pos -=  (child_node.size.height() + NODE_SPACING) * 0.5;
-            }
-
-            if( current_layer >= layer_cursor.size())
-            {
-                QPointF new_cursor( node->pos.x() + LEVEL_SPACING,
-                                    recommended_pos);
-                layer_cursor.push_back( new_cursor );
-                nodes_by_level.push_back( std::vector<AbstractTreeNode*>() );
-            }
-            else{
-                recommended_pos = std::max( recommended_pos, layer_cursor[current_layer].y() );
-                layer_cursor[current_layer].setY(recommended_pos);
-            }
-        }
-        //------------------------------------
-
-        auto initial_pos = layer_cursor[current_layer];
-
-        for(int index: node->children_index)
-        {
-            AbstractTreeNode* child_node = tree.node(index);
-
-            recursiveStep(current_layer, child_node);
-            if( layout == PortLayout::Vertical)
-            {
-                layer_cursor[current_layer]+= QPointF( child_node->size.width() + NODE_SPACING, 0 );
-            }
-            else{
-                layer_cursor[current_layer]+= QPointF( 0, child_node->size.height() + NODE_SPACING );
-            }
-        }
-
-        auto final_pos = layer_cursor[current_layer];
-
-        if( node->children_index.size() > 0)
-        {
-            auto first_child = tree.node( node->children_index.front() );
-            auto last_child = tree.node( node->children_index.back() );
-
-            initial_pos = QPointF( first_child->pos.x() + first_child->size.width()*0.5,
-                                   first_child->pos.y() + first_child->size.height()*0.5);
-
-            final_pos   = QPointF( last_child->pos.x() + last_child->size.width()*0.5,
-                                   last_child->pos.y() + last_child->size.height()*0.5);
-        }
-
-        // rebalance father
-        QPointF pos_offset(0,0);
-        if( layout == PortLayout::Vertical)
+        Node* node =  abs_node.graphic_node;
+        if( node == nullptr )
         {
-            double new_x = (final_pos.x() + initial_pos.x()) * 0.5 - node->size.width()*0.5;
-            double diff = node->pos.x() - new_x;
-            pos_offset = QPointF( - diff, 0 );
-        }
-        else{
-            double new_y = (final_pos.y() + initial_pos.y()) * 0.5 - node->size.height()*0.5;
-            double diff = node->pos.y() - new_y;
-            pos_offset = QPointF( 0, - diff );
+            throw std::runtime_error("one or more nodes haven't been created yet");
         }
+    }
 
-        node->pos += pos_offset;
-        layer_cursor[current_layer -1 ] += pos_offset;
-    };
+    if( tree.nodesCount() == 0)
+    {
+        return;
+    }
 
-    auto root_node = tree.rootNode();
-    layer_cursor.push_back(QPointF( -root_node->size.width()*0.5,
-                                    -root_node->size.height()*0.5));
-    recursiveStep(0, root_node);
+    TidyTreeLayout(tree, scene.layout() );
 
-    if( layout == PortLayout::Vertical)
+    QtNodes::ScopedNodesMove nodes_move( scene );
+    for (const auto& abs_node: tree.nodes())
     {
-        qreal offset = root_node->size.height() + LEVEL_SPACING;
-        for(unsigned i=1; i< nodes_by_level.size(); i++ )
-        {
-            qreal max_height = 0;
-            for(auto node: nodes_by_level[i])
-            {
-                max_height = std::max( max_height, node->size.height() );
-                node->pos.setY( offset );
-            }
-            offset += max_height + LEVEL_SPACING;
-        }
-    }
-    else{
-        qreal offset = root_node->size.width() + LEVEL_SPACING;
-        for(unsigned i=1; i< nodes_by_level.size(); i++ )
-        {
-            qreal max_width = 0;
-            for(auto node: nodes_by_level[i])
-            {
-                max_width = std::max( max_width, node->size.width() );
-                node->pos.setX( offset );
-            }
-            offset += max_width + LEVEL_SPACING;
-        }
+        Node* node =  abs_node.graphic_node;
+        scene.setNodePosition( *node, abs_node.pos );
     }
 }
 
-void NodeReorder(QtNodes::FlowScene &scene, AbsBehaviorTree & tree)
+std::vector<QtNodes::Node*> SubtreeReorder(QtNodes::FlowScene &scene,
+                                           AbsBehaviorTree &tree,
+                                           QtNodes::Node& subtree_root)
 {
-
+    std::vector<QtNodes::Node*> moved_nodes;
+    int subtree_index = -1;
+    std::vector<QPointF> prev_pos;
+    prev_pos.reserve( tree.nodesCount() );
     for (const auto& abs_node: tree.nodes())
     {
-        Node* node =  abs_node.graphic_node;
-        if( node == nullptr )
+        if( abs_node.graphic_node == nullptr )
         {
             throw std::runtime_error("one or more nodes haven't been created yet");
         }
+        if( abs_node.graphic_node == &subtree_root )
+        {
+            subtree_index = int( prev_pos.size() );
+        }
+        prev_pos.push_back( abs_node.pos );
     }
 
-    if( tree.nodesCount() == 0)
+    if( subtree_index < 0 )
     {
-        return;
+        NodeReorder( scene, tree );
+        for (const auto& abs_node: tree.nodes())
+        {
+            moved_nodes.push_back( abs_node.graphic_node );
+        }
+        return moved_nodes;
     }
 
-    RecursiveNodeReorder(tree, scene.layout() );
+    TidySubtreeLayout(tree, subtree_index, scene.layout() );
 
-    for (const auto& abs_node: tree.nodes())
     {
-        Node* node =  abs_node.graphic_node;
-        scene.setNodePosition( *node, abs_node.pos );
+        QtNodes::ScopedNodesMove nodes_move( scene );
+        for (size_t i = 0; i < tree.nodesCount(); i++)
+        {
+            const auto& abs_node = tree.nodes()[i];
+            if( abs_node.pos != prev_pos[i] )
+            {
+                scene.setNodePosition( *abs_node.graphic_node, abs_node.pos );
+                moved_nodes.push_back( abs_node.graphic_node );
+            }
+        }
     }
+    return moved_nodes;
 }
 
 
@@ -485,6 +409,55 @@ AbsBehaviorTree BuildTreeFromScene(const QtNodes::FlowScene *scene,
     return tree;
 }
 
+uint TreeStructureHash(const AbsBehaviorTree &tree)
+{
+    uint hash = 0;
+    auto combine = [&hash](uint value)
+    {
+        hash ^= value + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+    };
+
+    for(const auto& node: tree.nodes())
+    {
+        combine( static_cast<uint>(node.model.type) );
+        combine( qHash(node.model.registration_ID) );
+        combine( qHash(node.instance_name) );
+        for(const auto& it: node.ports_mapping)
+        {
+            combine( qHash(it.first) );
+            combine( qHash(it.second) );
+        }
+        combine( static_cast<uint>(node.children_index.size()) );
+        for(int child_index: node.children_index)
+        {
+            combine( static_cast<uint>(child_index) );
+        }
+    }
+    return hash;
+}
+
+bool SameTreeStructure(const AbsBehaviorTree &a, const AbsBehaviorTree &b)
+{
+    if( a.nodesCount() != b.nodesCount() )
+    {
+        return false;
+    }
+    auto it_b = b.nodes().begin();
+    for(const auto& node: a.nodes())
+    {
+        const auto& other = *(it_b++);
+        if( node.model.type != other.model.type ||
+            node.model.registration_ID != other.model.registration_ID ||
+            node.instance_name != other.instance_name ||
+            node.ports_mapping != other.ports_mapping ||
+            node.children_index != other.children_index )
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
 AbsBehaviorTree BuildTreeFromXML(const QDomElement& bt_root, const NodeModels& models )
 {
     AbsBehaviorTree tree;
@@ -699,7 +672,11 @@ getStyleFromStatus(NodeStatus status, NodeStatus prev_status)
 QtNodes::Node *GetParentNode(QtNodes::Node *node)
 {
     using namespace QtNodes;
-    auto conn_in = node->nodeState().connections(PortType::In, 0);
+    if( auto topology = GetTopology( node->nodeGraphicsObject().scene() ) )
+    {
+        return topology->parent( *node );
+    }
+    const auto& conn_in = node->nodeState().connections(PortType::In, 0);
     if( conn_in.size() == 0)
     {
         return nullptr;
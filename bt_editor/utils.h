@@ -25,8 +25,23 @@ BuildTreeFromFlatbuffers(const Serialization::BehaviorTree* bt );
 
 AbsBehaviorTree BuildTreeFromXML(const QDomElement &bt_root, const NodeModels &models);
 
+// Hash of the structure of the tree (models, names, port remapping and hierarchy).
+// Positions, sizes and status are ignored.
+uint TreeStructureHash(const AbsBehaviorTree& tree);
+
+// True if the trees have the same structure, i.e. the same elements used by
+// TreeStructureHash(). To be used when the hashes are equal.
+bool SameTreeStructure(const AbsBehaviorTree& a, const AbsBehaviorTree& b);
+
 void NodeReorder(QtNodes::FlowScene &scene, AbsBehaviorTree &abstract_tree );
 
+// Like NodeReorder, but only the subtree of subtree_root is laid out again (see
+// TidySubtreeLayout) and only the nodes that change position are moved.
+// Returns the moved nodes.
+std::vector<QtNodes::Node*> SubtreeReorder(QtNodes::FlowScene &scene,
+                                           AbsBehaviorTree &abstract_tree,
+                                           QtNodes::Node& subtree_root );
+
 std::pair<QtNodes::NodeStyle, QtNodes::ConnectionStyle>
 getStyleFromStatus(NodeStatus status, NodeStatus prev_status);
 
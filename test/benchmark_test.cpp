@@ -0,0 +1,627 @@
+#include "groot_test_base.h"
+#include "bt_editor/status_packet_decoder.h"
+#include "bt_editor/XML_utilities.hpp"
+#include "bt_editor/tree_layout.h"
+#include "nodes/Connection"
+#include <QElapsedTimer>
+#include <QGraphicsProxyWidget>
+#include <QImage>
+#include <QPainter>
+#include <QXmlStreamWriter>
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <type_traits>
+
+// std::allocator that counts the allocations of the containers using it.
+template <typename T>
+struct CountingAllocator
+{
+    typedef T value_type;
+
+    explicit CountingAllocator(size_t* count): count(count) {}
+
+    template <typename U>
+    CountingAllocator(const CountingAllocator<U>& other): count(other.count) {}
+
+    T* allocate(size_t n)
+    {
+        (*count)++;
+        return std::allocator<T>().allocate( n );
+    }
+
+    void deallocate(T* ptr, size_t n)
+    {
+        std::allocator<T>().deallocate( ptr, n );
+    }
+
+    size_t* count;
+};
+
+template <typename T, typename U>
+bool operator ==(const CountingAllocator<T>& a, const CountingAllocator<U>& b) { return a.count == b.count; }
+
+template <typename T, typename U>
+bool operator !=(const CountingAllocator<T>& a, const CountingAllocator<U>& b) { return a.count != b.count; }
+
+class BenchmarkTest : public GrootTestBase
+{
+    Q_OBJECT
+
+public:
+    BenchmarkTest() {}
+    ~BenchmarkTest() {}
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void statusDecoderLegacy();
+    void statusDecoder();
+    void sceneSnapshotJson();
+    void sceneSnapshotBinary();
+    void connectionsScan();
+    void treeLayout();
+    void nodesMove();
+    void nodeGeometry();
+    void lowDetailPaint();
+    void xmlProjectParse();
+
+private:
+    void reportRate(const char* name, int count, qint64 elapsed_ns);
+
+    void reportSnapshot(const char* name, int bytes, qint64 save_ns, qint64 load_ns);
+
+    // Status packets, as published by BT::PublisherZMQ
+    std::vector<std::vector<char>> _packets;
+    std::unordered_map<int, int> _uid_to_index;
+};
+
+static const int STATUS_NODES_COUNT = 500;
+static const int STATUS_TRANSITIONS_COUNT = 50;
+static const int STATUS_PACKETS_COUNT = 200;
+static const int SCENE_NODES_COUNT = 5000;
+static const int XML_TREES_COUNT = 300;
+static const int XML_TREE_NODES_COUNT = 200;
+
+void BenchmarkTest::initTestCase()
+{
+    for(int i=0; i < STATUS_NODES_COUNT; i++)
+    {
+        _uid_to_index.insert( { 1000 + i*3, i } );
+    }
+
+    auto write_u32 = [](char* dst, uint32_t value) { memcpy(dst, &value, 4); };
+    auto write_u16 = [](char* dst, uint16_t value) { memcpy(dst, &value, 2); };
+
+    for(int p=0; p < STATUS_PACKETS_COUNT; p++)
+    {
+        const uint32_t header_size = STATUS_NODES_COUNT * 3;
+        std::vector<char> packet( 8 + header_size + 12*STATUS_TRANSITIONS_COUNT );
+        char* buffer = packet.data();
+
+        write_u32( buffer, header_size );
+        for(int i=0; i < STATUS_NODES_COUNT; i++)
+        {
+            write_u16( &buffer[4 + i*3], 1000 + i*3 );
+            buffer[4 + i*3 + 2] = char( (i+p) % 4 );
+        }
+        write_u32( &buffer[4 + header_size], STATUS_TRANSITIONS_COUNT );
+        for(int t=0; t < STATUS_TRANSITIONS_COUNT; t++)
+        {
+            char* transition = &buffer[8 + header_size + 12*t];
+            write_u32( transition, p );
+            write_u32( transition + 4, t );
+            write_u16( transition + 8, 1000 + ((t*7+p) % STATUS_NODES_COUNT)*3 );
+            transition[10] = char( t % 4 );
+            transition[11] = char( (t+1) % 4 );
+        }
+        _packets.push_back( std::move(packet) );
+    }
+
+    main_win = new MainWindow(GraphicMode::EDITOR, nullptr);
+
+    // every Sequence has 4 children; the last ones are actions with ports
+    auto container = main_win->currentTabInfo();
+    const QSignalBlocker blocker( container );
+    auto scene = container->scene();
+    std::vector<QtNodes::Node*> nodes;
+    for(int i=0; i < SCENE_NODES_COUNT; i++)
+    {
+        const bool is_parent = i <= (SCENE_NODES_COUNT - 2) / 4;
+        auto& node = scene->createNodeAtPos( is_parent ? "Sequence" : "SetBlackboard",
+                                             QString("node_%1").arg(i),
+                                             QPointF( (i % 100) * 150, (i / 100) * 100 ) );
+        if( i > 0 )
+        {
+            scene->createConnection( node, 0, *nodes[(i-1)/4], 0 );
+        }
+        nodes.push_back( &node );
+    }
+}
+
+void BenchmarkTest::cleanupTestCase()
+{
+    main_win->on_actionClear_triggered();
+    main_win->close();
+}
+
+void BenchmarkTest::reportRate(const char* name, int count, qint64 elapsed_ns)
+{
+    qInfo("%s: %.0f packets/sec", name, double(count) * 1e9 / double(std::max<qint64>(elapsed_ns, 1)) );
+}
+
+// Decoder used by the SidepanelMonitor before StatusPacketDecoder:
+// two validation passes, an apply pass and a new vector for each packet.
+void BenchmarkTest::statusDecoderLegacy()
+{
+    std::vector<NodeStatus> status( STATUS_NODES_COUNT );
+    size_t transitions = 0;
+    int decoded = 0;
+    QElapsedTimer timer;
+    timer.start();
+
+    QBENCHMARK
+    {
+        for(const auto& packet: _packets)
+        {
+            const char* buffer = packet.data();
+            const uint32_t header_size = flatbuffers::ReadScalar<uint32_t>( buffer );
+            const uint32_t num_transitions = flatbuffers::ReadScalar<uint32_t>( &buffer[4+header_size] );
+
+            std::vector<std::pair<int, NodeStatus>> node_status;
+
+            for(size_t offset = 4; offset < header_size +4; offset +=3 )
+            {
+                const uint16_t uid = flatbuffers::ReadScalar<uint16_t>(&buffer[offset]);
+                _uid_to_index.at(uid);
+            }
+            for(size_t t=0; t < num_transitions; t++)
+            {
+                size_t offset = 8 + header_size + 12*t;
+                const uint16_t uid = flatbuffers::ReadScalar<uint16_t>(&buffer[offset+8]);
+                _uid_to_index.at(uid);
+            }
+            for(size_t offset = 4; offset < header_size +4; offset +=3 )
+            {
+                const uint16_t uid = flatbuffers::ReadScalar<uint16_t>(&buffer[offset]);
+                const int index = _uid_to_index.at(uid);
+                status[index] = convert(flatbuffers::ReadScalar<Serialization::NodeStatus>(&buffer[offset+2] ));
+            }
+            for(size_t t=0; t < num_transitions; t++)
+            {
+                size_t offset = 8 + header_size + 12*t;
+                const uint16_t uid = flatbuffers::ReadScalar<uint16_t>(&buffer[offset+8]);
+                const int index = _uid_to_index.at(uid);
+                NodeStatus new_status = convert(flatbuffers::ReadScalar<Serialization::NodeStatus>(&buffer[offset+11] ));
+                status[index] = new_status;
+                node_status.push_back( {index, new_status} );
+            }
+            transitions += node_status.size();
+            decoded++;
+        }
+    }
+    reportRate( "legacy decoder", decoded, timer.nsecsElapsed() );
+    qInfo("legacy decoder: %d transitions", int(transitions) );
+}
+
+void BenchmarkTest::statusDecoder()
+{
+    StatusPacketDecoder decoder;
+    decoder.setUidToIndex( _uid_to_index );
+
+    std::vector<NodeStatus> status( STATUS_NODES_COUNT );
+    std::vector<NodeStatusUpdate> updates;
+    size_t transitions = 0;
+    int decoded = 0;
+    QElapsedTimer timer;
+    timer.start();
+
+    QBENCHMARK
+    {
+        for(const auto& packet: _packets)
+        {
+            decoder.decode( packet.data(), packet.size(), updates );
+
+            for(const auto& update: updates)
+            {
+                status[update.index] = update.status;
+                transitions += update.is_transition ? 1 : 0;
+            }
+            decoded++;
+        }
+    }
+    reportRate( "StatusPacketDecoder", decoded, timer.nsecsElapsed() );
+    qInfo("StatusPacketDecoder: %d transitions", int(transitions) );
+}
+
+void BenchmarkTest::reportSnapshot(const char* name, int bytes, qint64 save_ns, qint64 load_ns)
+{
+    qInfo("%s: %d bytes, save %.1f ms, load %.1f ms", name, bytes, save_ns * 1e-6, load_ns * 1e-6 );
+}
+
+void BenchmarkTest::sceneSnapshotJson()
+{
+    auto container = main_win->currentTabInfo();
+    const QSignalBlocker blocker( container );
+    auto scene = container->scene();
+    const size_t connections_count = scene->connections().size();
+
+    QElapsedTimer timer;
+    timer.start();
+    QByteArray data = scene->saveToMemory();
+    qint64 save_ns = timer.nsecsElapsed();
+
+    scene->clearScene();
+    timer.restart();
+    scene->loadFromMemory( data );
+    qint64 load_ns = timer.nsecsElapsed();
+
+    reportSnapshot( "JSON snapshot", data.size(), save_ns, load_ns );
+    QCOMPARE( scene->nodes().size(), size_t(SCENE_NODES_COUNT + 1) );
+    QCOMPARE( scene->connections().size(), connections_count );
+}
+
+void BenchmarkTest::sceneSnapshotBinary()
+{
+    auto container = main_win->currentTabInfo();
+    const QSignalBlocker blocker( container );
+    auto scene = container->scene();
+
+    QElapsedTimer timer;
+    timer.start();
+    QByteArray data = scene->saveToBinary();
+    qint64 save_ns = timer.nsecsElapsed();
+
+    scene->clearScene();
+    timer.restart();
+    scene->loadFromBinary( data );
+    qint64 load_ns = timer.nsecsElapsed();
+
+    reportSnapshot( "binary snapshot", data.size(), save_ns, load_ns );
+    QCOMPARE( scene->nodes().size(), size_t(SCENE_NODES_COUNT + 1) );
+}
+
+// Parent and children of every node, read from the NodeState as the layout and
+// the monitoring do; NodeState::connections() returned a std::unordered_map by value.
+void BenchmarkTest::connectionsScan()
+{
+    auto scene = main_win->currentTabInfo()->scene();
+    std::vector<const QtNodes::Node*> nodes;
+    for (const auto& it: scene->nodes())
+    {
+        nodes.push_back( it.second.get() );
+    }
+
+    // the connections are read in place: there is no copy to allocate
+    static_assert( std::is_lvalue_reference<decltype(
+                       nodes.front()->nodeState().connections( PortType::In, 0 ))>::value,
+                   "NodeState::connections() must not return a copy" );
+
+    typedef std::pair<const QUuid, QtNodes::Connection*> ConnectionEntry;
+    typedef std::unordered_map<QUuid, QtNodes::Connection*, std::hash<QUuid>,
+                               std::equal_to<QUuid>, CountingAllocator<ConnectionEntry>> LegacyConnections;
+    size_t legacy_allocations = 0;
+    size_t legacy_links = 0;
+    size_t links = 0;
+    int scans = 0;
+
+    QElapsedTimer timer;
+    timer.start();
+    for(int i=0; i < 10; i++)
+    {
+        for(auto node: nodes)
+        {
+            for(PortType type: {PortType::In, PortType::Out})
+            {
+                const auto& set = node->nodeState().connections( type, 0 );
+                LegacyConnections connections( set.begin(), set.end(), 0, std::hash<QUuid>(),
+                                               std::equal_to<QUuid>(),
+                                               CountingAllocator<ConnectionEntry>( &legacy_allocations ) );
+                legacy_links += connections.size();
+            }
+        }
+    }
+    qint64 legacy_ns = timer.nsecsElapsed() / 10;
+
+    timer.restart();
+    QBENCHMARK
+    {
+        for(auto node: nodes)
+        {
+            for(PortType type: {PortType::In, PortType::Out})
+            {
+                for(const auto& it: node->nodeState().connections( type, 0 ))
+                {
+                    links += (it.second != nullptr) ? 1 : 0;
+                }
+            }
+        }
+        scans++;
+    }
+    qint64 scan_ns = timer.nsecsElapsed() / std::max(scans, 1);
+
+    qInfo("connections of %d nodes: %.2f ms per scan; with a map copy %.2f ms and %.1f allocations",
+          int(nodes.size()), scan_ns * 1e-6, legacy_ns * 1e-6, legacy_allocations / 10.0 );
+
+    QCOMPARE( links, size_t(scans) * 2 * scene->connections().size() );
+    QCOMPARE( legacy_links, size_t(10) * 2 * scene->connections().size() );
+}
+
+// Synthetic trees with nodes of random size and between 1 and 6 children each
+void BenchmarkTest::treeLayout()
+{
+    for(int nodes_count: {10000, 30000, 100000})
+    {
+        std::mt19937 random_engine( nodes_count );
+        std::uniform_int_distribution<int> children_count( 1, 6 );
+        std::uniform_int_distribution<int> node_width( 60, 300 );
+        std::uniform_int_distribution<int> node_height( 40, 120 );
+
+        AbsBehaviorTree tree;
+        AbstractTreeNode root;
+        root.size = QSizeF( 100, 50 );
+        tree.addNode( nullptr, std::move(root) );
+        for(size_t parent = 0; tree.nodesCount() < size_t(nodes_count); parent++)
+        {
+            for(int c = children_count( random_engine ); c > 0 && tree.nodesCount() < size_t(nodes_count); c--)
+            {
+                AbstractTreeNode node;
+                node.size = QSizeF( node_width( random_engine ), node_height( random_engine ) );
+                tree.addNode( tree.node(parent), std::move(node) );
+            }
+        }
+
+        for(QtNodes::PortLayout layout: {QtNodes::PortLayout::Vertical, QtNodes::PortLayout::Horizontal})
+        {
+            const bool vertical = (layout == QtNodes::PortLayout::Vertical);
+            QElapsedTimer timer;
+            timer.start();
+            TidyTreeLayout( tree, layout );
+            qint64 elapsed_ns = timer.nsecsElapsed();
+
+            qInfo("tidy tree layout, %d nodes, %s: %.1f ms", nodes_count,
+                  vertical ? "vertical" : "horizontal", elapsed_ns * 1e-6 );
+        }
+    }
+}
+
+// Every node of the scene moved by NodeReorder, one by one or in a single
+// FlowScene::beginNodesMove() / commitNodesMove()
+void BenchmarkTest::nodesMove()
+{
+    auto scene = main_win->currentTabInfo()->scene();
+    std::vector<QtNodes::Node*> nodes;
+    for (const auto& it: scene->nodes())
+    {
+        nodes.push_back( it.second.get() );
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    for(auto node: nodes)
+    {
+        scene->setNodePosition( *node, scene->getNodePosition( *node ) + QPointF( 10, 10 ) );
+    }
+    qint64 single_ns = timer.nsecsElapsed();
+
+    timer.restart();
+    {
+        QtNodes::ScopedNodesMove nodes_move( *scene );
+        for(auto node: nodes)
+        {
+            scene->setNodePosition( *node, scene->getNodePosition( *node ) - QPointF( 10, 10 ) );
+        }
+    }
+    qint64 batch_ns = timer.nsecsElapsed();
+
+    qInfo("move %d nodes: one by one %.1f ms, batch %.1f ms",
+          int(nodes.size()), single_ns * 1e-6, batch_ns * 1e-6 );
+}
+
+// What NodePainter::paint() computes for every node of a view, at every frame
+void BenchmarkTest::nodeGeometry()
+{
+    auto scene = main_win->currentTabInfo()->scene();
+    std::vector<QtNodes::Node*> nodes;
+    for (const auto& it: scene->nodes())
+    {
+        nodes.push_back( it.second.get() );
+    }
+    const QFont font = main_win->currentTabInfo()->view()->font();
+    for(auto node: nodes)
+    {
+        node->nodeGeometry().recalculateSize( font );
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    for(auto node: nodes)
+    {
+        node->nodeGeometry().recalculateSize( font );
+    }
+    qint64 paint_ns = timer.nsecsElapsed();
+
+    std::vector<QSizeF> sizes;
+    timer.restart();
+    for(auto node: nodes)
+    {
+        node->nodeGeometry().recalculateSize();
+        sizes.push_back( scene->getNodeSize( *node ) );
+    }
+    qint64 recalculate_ns = timer.nsecsElapsed();
+
+    qInfo("geometry of %d nodes: when painted %.2f ms, recalculated %.2f ms",
+          int(nodes.size()), paint_ns * 1e-6, recalculate_ns * 1e-6 );
+
+    // the font did not change: the size is not computed again, even if
+    // the embedded widget was resized in the meantime
+    auto with_widget = std::find_if( nodes.begin(), nodes.end(), [](QtNodes::Node* node)
+    {
+        return node->nodeDataModel()->embeddedWidget() != nullptr;
+    });
+    QVERIFY( with_widget != nodes.end() );
+    QWidget* widget = (*with_widget)->nodeDataModel()->embeddedWidget();
+    const QSize widget_size = widget->size();
+    const QSizeF node_size = scene->getNodeSize( **with_widget );
+    widget->resize( widget_size + QSize( 50, 0 ) );
+    (*with_widget)->nodeGeometry().recalculateSize( font );
+    QCOMPARE( scene->getNodeSize( **with_widget ), node_size );
+    widget->resize( widget_size );
+
+    // the metrics shared by the nodes are the same as their own
+    QFont other_font = font;
+    other_font.setBold( !font.bold() );
+    for(auto node: nodes)
+    {
+        node->nodeGeometry().recalculateSize( other_font );
+        node->nodeGeometry().recalculateSize( font );
+    }
+    for(size_t i = 0; i < nodes.size(); i++)
+    {
+        QCOMPARE( scene->getNodeSize( *nodes[i] ), sizes[i] );
+    }
+}
+
+// The whole scene in a small image, where the nodes are drawn as boxes
+// without their embedded widget, and then a part of it at 1:1 scale.
+void BenchmarkTest::lowDetailPaint()
+{
+    auto scene = main_win->currentTabInfo()->scene();
+    auto view = main_win->currentTabInfo()->view();
+    const QRectF scene_rect = scene->itemsBoundingRect();
+    const QTransform view_transform = view->transform();
+
+    auto proxyVisible = [](QtNodes::Node* node)
+    {
+        QWidget* widget = node->nodeDataModel()->embeddedWidget();
+        return widget && widget->graphicsProxyWidget() &&
+               widget->graphicsProxyWidget()->isVisible();
+    };
+
+    // the details are hidden when the view is zoomed out, not by paint()
+    while( !view->lowDetail() )
+    {
+        view->scaleDown();
+    }
+    for (const auto& it: scene->nodes())
+    {
+        QVERIFY( !proxyVisible( it.second.get() ) );
+    }
+
+    const double scale = std::min( 0.1, 1600 / scene_rect.width() );
+    QImage overview( (scene_rect.size() * scale).toSize() + QSize(1, 1),
+                     QImage::Format_ARGB32_Premultiplied );
+    QElapsedTimer timer;
+    timer.start();
+    {
+        QPainter painter( &overview );
+        painter.setRenderHint( QPainter::Antialiasing );
+        scene->render( &painter, QRectF(), scene_rect );
+    }
+    qint64 overview_ns = timer.nsecsElapsed();
+
+    while( view->lowDetail() )
+    {
+        view->scaleUp();
+    }
+    QtNodes::Node* first_node = scene->nodes().begin()->second.get();
+    const QRectF detail_rect( scene->getNodePosition( *first_node ), QSizeF(800, 600) );
+
+    QImage detail( detail_rect.size().toSize(), QImage::Format_ARGB32_Premultiplied );
+    timer.restart();
+    {
+        QPainter painter( &detail );
+        painter.setRenderHint( QPainter::Antialiasing );
+        scene->render( &painter, QRectF(), detail_rect );
+    }
+    qint64 detail_ns = timer.nsecsElapsed();
+
+    qInfo("painted %d nodes in %.1f ms at low detail, a 800x600 area at 1:1 in %.1f ms",
+          int(scene->nodes().size()), overview_ns * 1e-6, detail_ns * 1e-6 );
+
+    QVERIFY( proxyVisible( first_node ) );
+
+    view->setTransform( view_transform );
+    view->updateLevelOfDetail();
+}
+
+// Loader used by MainWindow::loadFromXML before ReadProjectFromXML: QDomDocument,
+// ReadTreeNodesModel and BuildTreeFromXML, compared with the streaming one.
+// EditorTest::xmlProjectParse() checks that they give the same trees.
+void BenchmarkTest::xmlProjectParse()
+{
+    // many subtrees; the custom model is declared at the end, as saveToXML() does
+    QString xml_text;
+    {
+        QXmlStreamWriter writer( &xml_text );
+        writer.setAutoFormatting(true);
+        writer.writeStartElement("root");
+        writer.writeAttribute("main_tree_to_execute", "Tree_0");
+        for(int t=0; t < XML_TREES_COUNT; t++)
+        {
+            writer.writeStartElement("BehaviorTree");
+            writer.writeAttribute("ID", QString("Tree_%1").arg(t) );
+            writer.writeStartElement("Sequence");
+            for(int i=0; i < XML_TREE_NODES_COUNT; i++)
+            {
+                if( i % 2 == 0 )
+                {
+                    writer.writeEmptyElement("SetBlackboard");
+                    writer.writeAttribute("output_key", QString("key_%1").arg(i) );
+                    writer.writeAttribute("value", QString("%1").arg(t) );
+                }
+                else{
+                    writer.writeEmptyElement("Action");
+                    writer.writeAttribute("ID", "CustomAction" );
+                    writer.writeAttribute("name", QString("action_%1").arg(i) );
+                    writer.writeAttribute("goal", "{goal}" );
+                }
+            }
+            writer.writeEndElement();
+            writer.writeEndElement();
+        }
+        writer.writeStartElement("TreeNodesModel");
+        writer.writeStartElement("Action");
+        writer.writeAttribute("ID", "CustomAction");
+        writer.writeStartElement("input_port");
+        writer.writeAttribute("name", "goal");
+        writer.writeAttribute("type", "Pose2D");
+        writer.writeCharacters("Where to go");
+        writer.writeEndElement();
+        writer.writeEndElement();
+        writer.writeEndElement();
+        writer.writeEndElement();
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    QDomDocument document;
+    QVERIFY( document.setContent( xml_text ) );
+    const auto document_root = document.documentElement();
+    NodeModels dom_models = ReadTreeNodesModel( document_root );
+    NodeModels all_models = main_win->registeredModels();
+    all_models.insert( dom_models.begin(), dom_models.end() );
+    std::vector<AbsBehaviorTree> dom_trees;
+    for (auto bt_root = document_root.firstChildElement("BehaviorTree");
+         !bt_root.isNull();
+         bt_root = bt_root.nextSiblingElement("BehaviorTree"))
+    {
+        dom_trees.push_back( BuildTreeFromXML( bt_root, all_models ) );
+    }
+    qint64 dom_ns = timer.nsecsElapsed();
+
+    timer.restart();
+    XmlProject project = ReadProjectFromXML( xml_text );
+    for(auto& xml_tree: project.trees)
+    {
+        AssignTreeModels( xml_tree.tree, all_models );
+    }
+    qint64 stream_ns = timer.nsecsElapsed();
+
+    qInfo("XML project: %d bytes, QDomDocument %.1f ms, QXmlStreamReader %.1f ms",
+          xml_text.toUtf8().size(), dom_ns * 1e-6, stream_ns * 1e-6 );
+}
+
+QTEST_MAIN(BenchmarkTest)
+
+#include "benchmark_test.moc"
@@ -1,7 +1,18 @@
 #include "groot_test_base.h"
 #include "bt_editor/sidepanel_editor.h"
+#include "bt_editor/tree_layout.h"
+#include "bt_editor/scene_diff.h"
+#include "bt_editor/XML_utilities.hpp"
+#include "nodes/Connection"
+#include "nodes/internal/ConnectionGraphicsObject.hpp"
 #include <QAction>
 #include <QLineEdit>
+#include <QTabWidget>
+#include <QTemporaryDir>
+#include <QXmlStreamWriter>
+#include <algorithm>
+#include <random>
+#include <set>
 
 class EditorTest : public GrootTestBase
 {
@@ -27,6 +38,17 @@ private slots:
     void longNames();
     void clearModels();
     void undoWithSubtreeExpanded();
+    void undoTouchesOnlyItsTab();
+    void lazyTabs();
+    void savedFilesAreCanonical();
+    void autosaveRecovery();
+    void topologyCache();
+    void subtreeReorder();
+    void sameTreeStructure();
+    void sceneSnapshotBinary();
+    void tidyTreeLayout();
+    void nodesMoveBatch();
+    void xmlProjectParse();
 };
 
 
@@ -633,6 +655,607 @@ void EditorTest::undoWithSubtreeExpanded()
      sleepAndRefresh( 500 );
 }
 
+void EditorTest::undoTouchesOnlyItsTab()
+{
+    QString file_xml = readFile(":/crossdoor_with_subtree.xml");
+    main_win->on_actionClear_triggered();
+    main_win->loadFromXML( file_xml );
+
+    auto main_container = main_win->getTabByName("MainTree");
+    auto door_container = main_win->getTabByName("DoorClosed");
+
+    std::set<QtNodes::Node*> door_nodes;
+    for(const auto& it: door_container->scene()->nodes())
+    {
+        door_nodes.insert( it.second.get() );
+    }
+
+    auto abs_tree = getAbstractTree("MainTree");
+    auto window_node = abs_tree.findFirstNode("PassThroughWindow")->graphic_node;
+
+    auto scene = main_container->scene();
+    size_t node_count = scene->nodes().size();
+    scene->removeNode(*window_node);
+    sleepAndRefresh( 500 );
+    QCOMPARE( scene->nodes().size(), node_count - 1 );
+
+    main_win->onUndoInvoked();
+    QVERIFY( main_win->getTabByName("MainTree") == main_container );
+    QVERIFY( main_win->getTabByName("DoorClosed") == door_container );
+    QCOMPARE( scene->nodes().size(), node_count );
+    QCOMPARE( getAbstractTree("MainTree"), abs_tree );
+
+    // the nodes of the other tab were not created again
+    std::set<QtNodes::Node*> door_nodes_after;
+    for(const auto& it: door_container->scene()->nodes())
+    {
+        door_nodes_after.insert( it.second.get() );
+    }
+    QVERIFY( door_nodes == door_nodes_after );
+
+    main_win->onRedoInvoked();
+    QCOMPARE( scene->nodes().size(), node_count - 1 );
+
+    sleepAndRefresh( 500 );
+}
+
+void EditorTest::lazyTabs()
+{
+    QString file_xml = readFile(":/crossdoor_with_subtree.xml");
+    main_win->on_actionClear_triggered();
+    main_win->loadFromXML( file_xml );
+
+    auto main_container = main_win->getTabByName("MainTree");
+    auto door_container = main_win->getTabByName("DoorClosed");
+    QVERIFY( main_win->currentTabInfo() == main_container );
+    QVERIFY( main_container->isMaterialized() );
+    QVERIFY( !door_container->isMaterialized() );
+
+    // saved and validated from the abstract tree
+    QVERIFY( door_container->containsValidTree() );
+    QString lazy_xml = main_win->saveToXML();
+    QVERIFY( !door_container->isMaterialized() );
+
+    // the expanded SubTree is copied from the abstract tree too
+    auto abs_tree = getAbstractTree("MainTree");
+    auto subtree_node = abs_tree.findFirstNode("DoorClosed")->graphic_node;
+    auto subtree_model = dynamic_cast<SubtreeNodeModel*>( subtree_node->nodeDataModel() );
+    const size_t collapsed_count = main_container->scene()->nodes().size();
+    QTest::mouseClick( subtree_model->expandButton(), Qt::LeftButton );
+    QVERIFY( main_container->scene()->nodes().size() > collapsed_count );
+    QVERIFY( !door_container->isMaterialized() );
+    QTest::mouseClick( subtree_model->expandButton(), Qt::LeftButton );
+
+    // changing the layout or the palette does not create the other scenes
+    main_win->on_toolButtonLayout_clicked();
+    QVERIFY( !door_container->isMaterialized() );
+
+    const NodeModel unused_model = { NodeType::ACTION, "LazyTabsAction", {} };
+    main_win->onAddToModelRegistry( unused_model );
+    main_win->onModelRemoveRequested( unused_model.registration_ID );
+    QVERIFY( !door_container->isMaterialized() );
+
+    // opening the tab creates the scene, without adding an undo step
+    auto door_tree = door_container->loadedTree();
+    main_win->findChild<QTabWidget*>("tabWidget")->setCurrentWidget( door_container->view() );
+    QVERIFY( door_container->isMaterialized() );
+    QVERIFY( door_container->scene()->layout() == main_container->scene()->layout() );
+    QCOMPARE( TreeStructureHash( getAbstractTree("DoorClosed") ), TreeStructureHash( door_tree ) );
+    QCOMPARE( main_win->saveToXML(), lazy_xml );
+
+    auto scene = door_container->scene();
+    const size_t node_count = scene->nodes().size();
+    auto door_abs_tree = getAbstractTree("DoorClosed");
+    scene->removeNode( *door_abs_tree.nodes().back().graphic_node );
+    sleepAndRefresh( 500 );
+    QCOMPARE( scene->nodes().size(), node_count - 1 );
+
+    main_win->onUndoInvoked();
+    QCOMPARE( door_container->scene()->nodes().size(), node_count );
+
+    main_win->on_toolButtonLayout_clicked();
+    sleepAndRefresh( 500 );
+}
+
+void EditorTest::savedFilesAreCanonical()
+{
+    // The references were written by the QDomDocument serializer used by
+    // saveToXML() before QXmlStreamWriter, loading each file in a fresh state.
+    // The last one is the text saved again after loading the first reference:
+    // the tree of issue_24.xml has no ID, once saved it becomes the main tree.
+    struct SavedFiles { const char* input; const char* saved; const char* resaved; };
+    const SavedFiles files[] = {
+        { ":/crossdoor_with_subtree.xml",        ":/crossdoor_with_subtree_saved.xml",
+          ":/crossdoor_with_subtree_saved.xml" },
+        { ":/test_subtrees_issue_8.xml",         ":/test_subtrees_issue_8_saved.xml",
+          ":/test_subtrees_issue_8_saved.xml" },
+        { ":/show_all.xml",                      ":/show_all_saved.xml",
+          ":/show_all_saved.xml" },
+        { ":/issue_24.xml",                      ":/issue_24_saved.xml",
+          ":/issue_24_resaved.xml" },
+        { ":/test_xml_key_reordering_issue.xml", ":/test_xml_key_reordering_issue_saved.xml",
+          ":/test_xml_key_reordering_issue_saved.xml" } };
+
+    auto tab_widget = main_win->findChild<QTabWidget*>("tabWidget");
+
+    for(const auto& file: files)
+    {
+        const char* file_name = file.input;
+        const QString expected_xml = QString::fromUtf8( readFile(file.saved) );
+        const QString resaved_xml  = QString::fromUtf8( readFile(file.resaved) );
+
+        main_win->on_actionClear_triggered();
+        main_win->loadFromXML( readFile(file_name) );
+        QVERIFY2( main_win->saveToXML() == expected_xml, file_name );
+
+        // loading the saved file again gives back the same text
+        main_win->on_actionClear_triggered();
+        main_win->loadFromXML( expected_xml );
+        QVERIFY2( main_win->saveToXML() == resaved_xml, file_name );
+
+        // same output when the trees are written from their scenes
+        for(int i = 0; i < tab_widget->count(); i++)
+        {
+            tab_widget->setCurrentIndex( i );
+        }
+        QVERIFY2( main_win->saveToXML() == resaved_xml, file_name );
+    }
+
+    sleepAndRefresh( 500 );
+}
+
+void EditorTest::autosaveRecovery()
+{
+    QTemporaryDir autosave_dir;
+    QString file_xml = readFile(":/crossdoor_with_subtree.xml");
+    main_win->on_actionClear_triggered();
+    main_win->loadFromXML( file_xml );
+    QVERIFY( main_win->startAutosave( autosave_dir.path() ) );
+
+    // the change of a single tab is appended to the journal
+    auto door_tree = getAbstractTree("DoorClosed");
+    auto door_scene = main_win->getTabByName("DoorClosed")->scene();
+    door_scene->removeNode( *door_tree.nodes().back().graphic_node );
+    sleepAndRefresh( 1500 );
+
+    const uint main_hash = TreeStructureHash( getAbstractTree("MainTree") );
+    const uint door_hash = TreeStructureHash( getAbstractTree("DoorClosed") );
+
+    // crash while a record was being written
+    main_win->stopAutosave( false );
+    QFile journal( autosave_dir.filePath("journal.bin") );
+    QVERIFY( journal.open( QIODevice::Append ) );
+    QVERIFY( journal.size() > 12 ); // more than the header
+    journal.write( QByteArray( 7, 'x' ) );
+    journal.close();
+
+    main_win->on_actionClear_triggered();
+    QVERIFY( main_win->recoverAutosave( autosave_dir.path() ) );
+    QCOMPARE( TreeStructureHash( getAbstractTree("MainTree") ), main_hash );
+    QCOMPARE( TreeStructureHash( getAbstractTree("DoorClosed") ), door_hash );
+
+    sleepAndRefresh( 500 );
+}
+
+void EditorTest::topologyCache()
+{
+    QString file_xml = readFile(":/crossdoor_with_subtree.xml");
+    main_win->on_actionClear_triggered();
+    main_win->loadFromXML( file_xml );
+
+    auto container = main_win->getTabByName("MainTree");
+    auto scene = container->scene();
+
+    // compare the cache with the connections stored in the nodes
+    auto verifyTopology = [scene]()
+    {
+        using namespace QtNodes;
+        std::set<Node*> roots;
+        for(const auto& it: scene->nodes())
+        {
+            Node* node = it.second.get();
+            std::set<Node*> expected_children;
+            for(const auto& conn: node->nodeState().connections(PortType::Out, 0))
+            {
+                expected_children.insert( conn.second->getNode(PortType::In) );
+            }
+            auto children = getChildren( *scene, *node, true );
+            QCOMPARE( std::set<Node*>( children.begin(), children.end() ), expected_children );
+
+            Node* expected_parent = nullptr;
+            for(const auto& conn: node->nodeState().connections(PortType::In, 0))
+            {
+                expected_parent = conn.second->getNode(PortType::Out);
+            }
+            QCOMPARE( GetParentNode( node ), expected_parent );
+            if( !expected_parent )
+            {
+                roots.insert( node );
+            }
+        }
+        QCOMPARE( findRoot( *scene ), roots.size() == 1 ? *roots.begin() : nullptr );
+    };
+
+    verifyTopology();
+
+    // children are ordered by position, even when moved without notification
+    auto tree = getAbstractTree("MainTree");
+    auto sequence = tree.findFirstNode("door_open_sequence")->graphic_node;
+    auto children = getChildren( *scene, *sequence, true );
+    QVERIFY( children.size() > 1 );
+    QPointF first_pos = scene->getNodePosition( *children.front() );
+    scene->setNodePosition( *children.front(),
+                            scene->getNodePosition( *children.back() ) + QPointF(500, 0) );
+    QCOMPARE( getChildren( *scene, *sequence, true ).back(), children.front() );
+    scene->setNodePosition( *children.front(), first_pos );
+    QCOMPARE( getChildren( *scene, *sequence, true ), children );
+
+    // removing a node removes its connections
+    scene->removeNode( *sequence );
+    verifyTopology();
+    QVERIFY( findRoot( *scene ) == nullptr );
+
+    main_win->onUndoInvoked();
+    scene = container->scene();
+    verifyTopology();
+    QVERIFY( findRoot( *scene ) != nullptr );
+
+    sleepAndRefresh( 500 );
+}
+
+void EditorTest::subtreeReorder()
+{
+    QString file_xml = readFile(":/crossdoor_with_subtree.xml");
+    main_win->on_actionClear_triggered();
+    main_win->loadFromXML( file_xml );
+
+    auto container = main_win->getTabByName("MainTree");
+    auto scene = container->scene();
+    container->nodeReorder();
+
+    auto nodeRect = [scene](QtNodes::Node* node)
+    {
+        return QRectF( scene->getNodePosition( *node ), scene->getNodeSize( *node ) );
+    };
+    auto positions = [scene]()
+    {
+        std::map<QtNodes::Node*, QPointF> positions;
+        for(const auto& it: scene->nodes())
+        {
+            positions[ it.second.get() ] = scene->getNodePosition( *it.second );
+        }
+        return positions;
+    };
+
+    // nothing changed: nothing moves
+    auto tree = getAbstractTree("MainTree");
+    const auto prev_positions = positions();
+    container->nodeReorder( *tree.findFirstNode("door_open_sequence")->graphic_node );
+    QVERIFY( positions() == prev_positions );
+
+    // the ancestors of the expanded SubTree keep their position
+    auto subtree_node = tree.findFirstNode("DoorClosed")->graphic_node;
+    auto subtree_model = dynamic_cast<SubtreeNodeModel*>( subtree_node->nodeDataModel() );
+    QTest::mouseClick( subtree_model->expandButton(), Qt::LeftButton );
+    QVERIFY( subtree_model->expanded() );
+    QVERIFY( scene->nodes().size() > prev_positions.size() );
+
+    for(auto node = GetParentNode( subtree_node ); node != nullptr; node = GetParentNode( node ))
+    {
+        QCOMPARE( scene->getNodePosition( *node ), prev_positions.at( node ) );
+    }
+
+    for(const auto& a: scene->nodes())
+    {
+        for(const auto& b: scene->nodes())
+        {
+            if( a.first != b.first )
+            {
+                QVERIFY( !nodeRect( a.second.get() ).intersects( nodeRect( b.second.get() ) ) );
+            }
+        }
+    }
+
+    // An edited node larger than the other nodes of its level reaches the depth
+    // of the next level: there, the nodes of the other branches must not overlap.
+    // root -> edited  -> large
+    //      -> sibling -> narrow -> wide
+    for(QtNodes::PortLayout layout: {QtNodes::PortLayout::Vertical, QtNodes::PortLayout::Horizontal})
+    {
+        const bool vertical = (layout == QtNodes::PortLayout::Vertical);
+        auto size = [vertical](qreal along_siblings, qreal across_levels)
+        {
+            return vertical ? QSizeF( along_siblings, across_levels ) :
+                              QSizeF( across_levels, along_siblings );
+        };
+        auto addNode = [](AbsBehaviorTree& abs_tree, int parent, QSizeF node_size)
+        {
+            AbstractTreeNode node;
+            node.size = node_size;
+            abs_tree.addNode( parent < 0 ? nullptr : abs_tree.node(parent), std::move(node) );
+            return int(abs_tree.nodesCount()) - 1;
+        };
+        AbsBehaviorTree abs_tree;
+        const int root    = addNode( abs_tree, -1, size( 100, 50 ) );
+        const int edited  = addNode( abs_tree, root, size( 100, 50 ) );
+        const int sibling = addNode( abs_tree, root, size( 100, 50 ) );
+        const int large   = addNode( abs_tree, edited, size( 100, 50 ) );
+        const int narrow  = addNode( abs_tree, sibling, size( 40, 50 ) );
+        addNode( abs_tree, narrow, size( 400, 50 ) );
+        TidyTreeLayout( abs_tree, layout );
+
+        abs_tree.node(large)->size = size( 100, 300 );
+        TidySubtreeLayout( abs_tree, edited, layout );
+
+        for(const auto& a: abs_tree.nodes())
+        {
+            for(const auto& b: abs_tree.nodes())
+            {
+                if( &a != &b )
+                {
+                    QVERIFY( !QRectF( a.pos, a.size ).intersects( QRectF( b.pos, b.size ) ) );
+                }
+            }
+        }
+    }
+    sleepAndRefresh( 500 );
+}
+
+void EditorTest::sameTreeStructure()
+{
+    QString file_xml = readFile(":/crossdoor_with_subtree.xml");
+    main_win->on_actionClear_triggered();
+    main_win->loadFromXML( file_xml );
+
+    const auto tree = getAbstractTree("MainTree");
+
+    // positions and sizes are not part of the structure
+    auto moved = tree;
+    for(auto& node: moved.nodes())
+    {
+        node.pos += QPointF( 10, 10 );
+    }
+    QVERIFY( SameTreeStructure( tree, moved ) );
+
+    // same names, different hierarchy
+    auto swapped = tree;
+    auto parent = std::find_if( swapped.nodes().begin(), swapped.nodes().end(),
+                                [](const AbstractTreeNode& node) { return node.children_index.size() > 1; } );
+    QVERIFY( parent != swapped.nodes().end() );
+    std::reverse( parent->children_index.begin(), parent->children_index.end() );
+    QVERIFY( !SameTreeStructure( tree, swapped ) );
+
+    // same names, different port remapping
+    auto remapped = tree;
+    remapped.nodes().back().ports_mapping["remapped_port"] = "{value}";
+    QVERIFY( !SameTreeStructure( tree, remapped ) );
+}
+
+void EditorTest::sceneSnapshotBinary()
+{
+    QString file_xml = readFile(":/crossdoor_with_subtree.xml");
+    main_win->on_actionClear_triggered();
+    main_win->loadFromXML( file_xml );
+
+    auto container = main_win->getTabByName("MainTree");
+    const QSignalBlocker blocker( container );
+    auto scene = container->scene();
+    const size_t nodes_count = scene->nodes().size();
+    SceneSnapshot original( *scene );
+
+    QByteArray data = scene->saveToBinary();
+    scene->clearScene();
+    scene->loadFromBinary( data );
+
+    QCOMPARE( scene->nodes().size(), nodes_count );
+    QVERIFY( SceneDiff( original, SceneSnapshot( *scene ) ).empty() );
+
+    // the snapshot writes the same format
+    QCOMPARE( original.toBinary().size(), data.size() );
+
+    QVERIFY_EXCEPTION_THROWN( scene->loadFromBinary( data.mid(0, 6) ), std::runtime_error );
+}
+
+// Random trees with nodes of random size and between 1 and 6 children each
+void EditorTest::tidyTreeLayout()
+{
+    const qreal NODE_SPACING = 40;
+    const int nodes_count = 3000;
+
+    std::mt19937 random_engine( nodes_count );
+    std::uniform_int_distribution<int> children_count( 1, 6 );
+    std::uniform_int_distribution<int> node_width( 60, 300 );
+    std::uniform_int_distribution<int> node_height( 40, 120 );
+
+    AbsBehaviorTree tree;
+    AbstractTreeNode root;
+    root.size = QSizeF( 100, 50 );
+    tree.addNode( nullptr, std::move(root) );
+    for(size_t parent = 0; tree.nodesCount() < size_t(nodes_count); parent++)
+    {
+        for(int c = children_count( random_engine ); c > 0 && tree.nodesCount() < size_t(nodes_count); c--)
+        {
+            AbstractTreeNode node;
+            node.size = QSizeF( node_width( random_engine ), node_height( random_engine ) );
+            tree.addNode( tree.node(parent), std::move(node) );
+        }
+    }
+
+    for(QtNodes::PortLayout layout: {QtNodes::PortLayout::Vertical, QtNodes::PortLayout::Horizontal})
+    {
+        const bool vertical = (layout == QtNodes::PortLayout::Vertical);
+        TidyTreeLayout( tree, layout );
+
+        // along the siblings: begin, end; across: the level
+        auto begin = [&](const AbstractTreeNode& n) { return vertical ? n.pos.x() : n.pos.y(); };
+        auto end = [&](const AbstractTreeNode& n) {
+            return vertical ? (n.pos.x() + n.size.width()) : (n.pos.y() + n.size.height()); };
+        auto level = [&](const AbstractTreeNode& n) { return vertical ? n.pos.y() : n.pos.x(); };
+
+        std::vector<const AbstractTreeNode*> sorted;
+        for(const auto& node: tree.nodes())
+        {
+            sorted.push_back( &node );
+            if( !node.children_index.empty() )
+            {
+                const auto& first = tree.nodes()[ node.children_index.front() ];
+                const auto& last  = tree.nodes()[ node.children_index.back() ];
+                // centered on the first and the last child
+                QVERIFY( qAbs( (begin(first) + end(first) + begin(last) + end(last))*0.25 -
+                               (begin(node) + end(node))*0.5 ) < 1e-6 );
+            }
+        }
+        std::sort( sorted.begin(), sorted.end(),
+                   [&](const AbstractTreeNode* a, const AbstractTreeNode* b)
+        {
+            return level(*a) < level(*b) || (level(*a) == level(*b) && begin(*a) < begin(*b));
+        });
+        for(size_t i = 1; i < sorted.size(); i++)
+        {
+            if( level(*sorted[i-1]) == level(*sorted[i]) )
+            {
+                QVERIFY( end(*sorted[i-1]) + NODE_SPACING <= begin(*sorted[i]) + 1e-6 );
+            }
+        }
+    }
+}
+
+// The connections are updated once, by FlowScene::commitNodesMove()
+void EditorTest::nodesMoveBatch()
+{
+    QString file_xml = readFile(":/crossdoor_with_subtree.xml");
+    main_win->on_actionClear_triggered();
+    main_win->loadFromXML( file_xml );
+
+    auto scene = main_win->getTabByName("MainTree")->scene();
+    std::vector<QtNodes::Node*> nodes;
+    for (const auto& it: scene->nodes())
+    {
+        nodes.push_back( it.second.get() );
+    }
+
+    std::vector<std::pair<QPointF, QPointF>> end_points;
+    for (const auto& it: scene->connections())
+    {
+        auto& geometry = it.second->connectionGeometry();
+        end_points.push_back( { geometry.getEndPoint( PortType::In ),
+                                geometry.getEndPoint( PortType::Out ) } );
+    }
+
+    {
+        QtNodes::ScopedNodesMove nodes_move( *scene );
+        for(auto node: nodes)
+        {
+            scene->setNodePosition( *node, scene->getNodePosition( *node ) + QPointF( 10, 20 ) );
+        }
+        // no connection is updated until the commit
+        size_t index = 0;
+        for (const auto& it: scene->connections())
+        {
+            auto& geometry = it.second->connectionGeometry();
+            QCOMPARE( geometry.getEndPoint( PortType::In ), end_points[index].first );
+            QCOMPARE( geometry.getEndPoint( PortType::Out ), end_points[index].second );
+            index++;
+        }
+    }
+
+    // the connections are where they would be if moved again
+    for (const auto& it: scene->connections())
+    {
+        auto& geometry = it.second->connectionGeometry();
+        const QPointF in = geometry.getEndPoint( PortType::In );
+        const QPointF out = geometry.getEndPoint( PortType::Out );
+        it.second->connectionGraphicsObject().move();
+        QCOMPARE( geometry.getEndPoint( PortType::In ), in );
+        QCOMPARE( geometry.getEndPoint( PortType::Out ), out );
+    }
+}
+
+// ReadProjectFromXML() and AssignTreeModels() give the same models and trees
+// of ReadTreeNodesModel() and BuildTreeFromXML() on a QDomDocument.
+void EditorTest::xmlProjectParse()
+{
+    const int trees_count = 5;
+    const int tree_nodes_count = 20;
+
+    // the custom model is declared at the end, as saveToXML() does
+    QString xml_text;
+    {
+        QXmlStreamWriter writer( &xml_text );
+        writer.setAutoFormatting(true);
+        writer.writeStartElement("root");
+        writer.writeAttribute("main_tree_to_execute", "Tree_0");
+        for(int t=0; t < trees_count; t++)
+        {
+            writer.writeStartElement("BehaviorTree");
+            writer.writeAttribute("ID", QString("Tree_%1").arg(t) );
+            writer.writeStartElement("Sequence");
+            for(int i=0; i < tree_nodes_count; i++)
+            {
+                if( i % 2 == 0 )
+                {
+                    writer.writeEmptyElement("SetBlackboard");
+                    writer.writeAttribute("output_key", QString("key_%1").arg(i) );
+                    writer.writeAttribute("value", QString("%1").arg(t) );
+                }
+                else{
+                    writer.writeEmptyElement("Action");
+                    writer.writeAttribute("ID", "CustomAction" );
+                    writer.writeAttribute("name", QString("action_%1").arg(i) );
+                    writer.writeAttribute("goal", "{goal}" );
+                }
+            }
+            writer.writeEndElement();
+            writer.writeEndElement();
+        }
+        writer.writeStartElement("TreeNodesModel");
+        writer.writeStartElement("Action");
+        writer.writeAttribute("ID", "CustomAction");
+        writer.writeStartElement("input_port");
+        writer.writeAttribute("name", "goal");
+        writer.writeAttribute("type", "Pose2D");
+        writer.writeCharacters("Where to go");
+        writer.writeEndElement();
+        writer.writeEndElement();
+        writer.writeEndElement();
+        writer.writeEndElement();
+    }
+
+    QDomDocument document;
+    QVERIFY( document.setContent( xml_text ) );
+    const auto document_root = document.documentElement();
+    NodeModels dom_models = ReadTreeNodesModel( document_root );
+    NodeModels all_models = main_win->registeredModels();
+    all_models.insert( dom_models.begin(), dom_models.end() );
+    std::vector<AbsBehaviorTree> dom_trees;
+    for (auto bt_root = document_root.firstChildElement("BehaviorTree");
+         !bt_root.isNull();
+         bt_root = bt_root.nextSiblingElement("BehaviorTree"))
+    {
+        dom_trees.push_back( BuildTreeFromXML( bt_root, all_models ) );
+    }
+
+    XmlProject project = ReadProjectFromXML( xml_text );
+    for(auto& xml_tree: project.trees)
+    {
+        AssignTreeModels( xml_tree.tree, all_models );
+    }
+
+    QCOMPARE( project.main_tree, QString("Tree_0") );
+    QVERIFY( project.models == dom_models );
+    QCOMPARE( project.models.at("CustomAction").ports.at("goal").description, QString("Where to go") );
+    QCOMPARE( project.trees.size(), dom_trees.size() );
+    for(size_t t=0; t < dom_trees.size(); t++)
+    {
+        QCOMPARE( project.trees[t].ID, QString("Tree_%1").arg(t) );
+        QCOMPARE( project.trees[t].tree.nodesCount(), size_t(tree_nodes_count + 1) );
+        QVERIFY( SameTreeStructure( project.trees[t].tree, dom_trees[t] ) );
+    }
+
+    QVERIFY_EXCEPTION_THROWN( ReadProjectFromXML( xml_text.left( xml_text.size() / 2 ) ),
+                              std::runtime_error );
+}
+
 QTEST_MAIN(EditorTest)
 
 #include "editor_test.moc"
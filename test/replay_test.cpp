@@ -1,6 +1,10 @@
 #include "groot_test_base.h"
 #include "bt_editor/sidepanel_replay.h"
+#include "bt_editor/replay_log.h"
+#include "bt_editor/status_packet_decoder.h"
 #include <QAction>
+#include <cstring>
+#include <functional>
 
 class ReplyTest : public GrootTestBase
 {
@@ -14,6 +18,10 @@ private slots:
     void initTestCase();
     void cleanupTestCase();
     void basicLoad();
+    void sparseKeyframes();
+    void statusPacketDecoder();
+    void filterModel();
+    void tableModel();
 };
 
 
@@ -43,6 +51,245 @@ void ReplyTest::basicLoad()
     QCOMPARE( sidepanel_replay->transitionsCount(), size_t(27) );
 }
 
+// An idle robot: the transitions of crossdoor_trace.fbl, repeated, 20 seconds apart
+void ReplyTest::sparseKeyframes()
+{
+    const QByteArray trace = readFile("://crossdoor_trace.fbl");
+    uint32_t bt_header_size = 0;
+    memcpy( &bt_header_size, trace.data(), 4 );
+    const int header_size = 4 + int(bt_header_size);
+    const int trace_rows = (trace.size() - header_size) / 12;
+    const int repetitions = 200;
+
+    QByteArray log = trace.left( header_size );
+    for(int r=0; r < repetitions; r++)
+    {
+        for(int t=0; t < trace_rows; t++)
+        {
+            QByteArray record = trace.mid( header_size + 12*t, 12 );
+            const uint32_t t_sec = 20 * uint32_t(r*trace_rows + t);
+            const uint32_t t_usec = 0;
+            memcpy( record.data(), &t_sec, 4 );
+            memcpy( record.data() + 4, &t_usec, 4 );
+            log.append( record );
+        }
+    }
+
+    ReplayLog replay;
+    QCOMPARE( replay.setContent( log ), ReplayLog::SUCCESS );
+    const size_t rows = replay.transitionsCount();
+    QCOMPARE( rows, size_t(repetitions * trace_rows) );
+
+    // not one keyframe per row
+    QVERIFY( replay.keyframesCount() > 0 );
+    QVERIFY( replay.keyframesCount() <= rows / ReplayLog::KEYFRAME_MIN_ROWS + 1 );
+
+    // the status restored from a keyframe is the same of a replay from the last restart
+    std::vector<ReplayLog::NodeStatusPair> status;
+    for(size_t row: {rows/3, rows/2, rows-1})
+    {
+        replay.statusAt( row, status );
+
+        const ReplayLog::NodeStatusPair idle_pair = { NodeStatus::IDLE, NodeStatus::IDLE };
+        std::vector<ReplayLog::NodeStatusPair> expected( replay.tree().nodesCount(), idle_pair );
+        for(size_t t = replay.nearestRestart( row ); t <= row; t++)
+        {
+            const auto transition = replay.transition( t );
+            expected[transition.index].prev_status = expected[transition.index].status;
+            expected[transition.index].status = transition.status;
+        }
+
+        QCOMPARE( status.size(), expected.size() );
+        for(size_t i=0; i < status.size(); i++)
+        {
+            QVERIFY( status[i].prev_status == expected[i].prev_status );
+            QVERIFY( status[i].status == expected[i].status );
+        }
+    }
+}
+
+// A packet of BT::PublisherZMQ: the status of every node, then the transitions
+void ReplyTest::statusPacketDecoder()
+{
+    const int nodes_count = 20;
+    const int transitions_count = 7;
+
+    std::unordered_map<int, int> uid_to_index;
+    for(int i=0; i < nodes_count; i++)
+    {
+        uid_to_index.insert( { 1000 + i*3, i } );
+    }
+
+    auto write_u32 = [](char* dst, uint32_t value) { memcpy(dst, &value, 4); };
+    auto write_u16 = [](char* dst, uint16_t value) { memcpy(dst, &value, 2); };
+
+    const uint32_t header_size = nodes_count * 3;
+    std::vector<char> packet( 8 + header_size + 12*transitions_count );
+    char* buffer = packet.data();
+
+    write_u32( buffer, header_size );
+    for(int i=0; i < nodes_count; i++)
+    {
+        write_u16( &buffer[4 + i*3], 1000 + i*3 );
+        buffer[4 + i*3 + 2] = char( i % 4 );
+    }
+    write_u32( &buffer[4 + header_size], transitions_count );
+    for(int t=0; t < transitions_count; t++)
+    {
+        char* transition = &buffer[8 + header_size + 12*t];
+        write_u32( transition, t );
+        write_u32( transition + 4, 0 );
+        write_u16( transition + 8, 1000 + ((t*7) % nodes_count)*3 );
+        transition[10] = char( t % 4 );
+        transition[11] = char( (t+1) % 4 );
+    }
+
+    StatusPacketDecoder decoder;
+    decoder.setUidToIndex( uid_to_index );
+
+    std::vector<NodeStatusUpdate> updates;
+    QCOMPARE( decoder.decode( packet.data(), packet.size(), updates ),
+              StatusPacketDecoder::SUCCESS );
+
+    // the header first, then the transitions, in the order of the packet
+    QCOMPARE( updates.size(), size_t(nodes_count + transitions_count) );
+    for(int i=0; i < nodes_count; i++)
+    {
+        QCOMPARE( int(updates[i].index), i );
+        QVERIFY( updates[i].status == convert( Serialization::NodeStatus( i % 4 ) ) );
+        QVERIFY( !updates[i].is_transition );
+    }
+    for(int t=0; t < transitions_count; t++)
+    {
+        const auto& update = updates[nodes_count + t];
+        QCOMPARE( int(update.index), (t*7) % nodes_count );
+        QVERIFY( update.status == convert( Serialization::NodeStatus( (t+1) % 4 ) ) );
+        QVERIFY( update.is_transition );
+    }
+
+    // truncated packet and unknown UID
+    QCOMPARE( decoder.decode( packet.data(), packet.size() - 1, updates ),
+              StatusPacketDecoder::MALFORMED_PACKET );
+
+    decoder.clear();
+    QCOMPARE( decoder.decode( packet.data(), packet.size(), updates ),
+              StatusPacketDecoder::UNKNOWN_UID );
+}
+
+// The rows of the filter are the ones found by a scan of the whole log
+void ReplyTest::filterModel()
+{
+    ReplayLog replay;
+    QCOMPARE( replay.setContent( readFile("://crossdoor_trace.fbl") ), ReplayLog::SUCCESS );
+    const int rows = static_cast<int>( replay.transitionsCount() );
+
+    ReplayTableModel table_model( replay );
+    table_model.reload();
+    ReplayFilterModel filter_model( replay );
+    filter_model.setSourceModel( &table_model );
+    QCOMPARE( filter_model.rowCount(), rows );
+
+    auto checkRows = [&](const std::function<bool(const ReplayLog::Transition&)>& accepted)
+    {
+        std::vector<int> expected;
+        for(int row = 0; row < rows; row++)
+        {
+            if( accepted( replay.transition(row) ) )
+            {
+                expected.push_back( row );
+            }
+        }
+        QVERIFY( !expected.empty() && int(expected.size()) < rows );
+        QCOMPARE( filter_model.rowCount(), int(expected.size()) );
+
+        size_t next = 0;
+        for(int row = 0; row < rows; row++)
+        {
+            const QModelIndex proxy_index = filter_model.mapFromSource( table_model.index(row, 0) );
+            if( next < expected.size() && expected[next] == row )
+            {
+                QCOMPARE( proxy_index.row(), int(next) );
+                QCOMPARE( filter_model.mapToSource( filter_model.index(int(next), 0) ).row(), row );
+                next++;
+            }
+            else{
+                QVERIFY( !proxy_index.isValid() );
+            }
+        }
+    };
+
+    // case insensitive name of a node
+    const QString name = replay.tree().node( replay.transition(0).index )->instance_name;
+    ReplayFilterModel::Filter filter;
+    filter.name = name.toUpper();
+    filter_model.setFilter( filter );
+    checkRows( [&](const ReplayLog::Transition& transition)
+    {
+        return replay.tree().node( transition.index )->instance_name.contains( name, Qt::CaseInsensitive );
+    });
+
+    // type, status and time range together
+    filter = ReplayFilterModel::Filter();
+    filter.types.insert( NodeType::ACTION );
+    filter.status_mask = 1u << static_cast<int>( NodeStatus::SUCCESS );
+    const double first_timestamp = replay.timestamp(0);
+    filter.max_time = replay.timestamp( rows - 1 ) - first_timestamp;
+    filter.min_time = replay.timestamp( rows / 4 ) - first_timestamp;
+    filter_model.setFilter( filter );
+    checkRows( [&](const ReplayLog::Transition& transition)
+    {
+        const double time = transition.timestamp - first_timestamp;
+        return replay.tree().node( transition.index )->model.type == NodeType::ACTION &&
+               transition.status == NodeStatus::SUCCESS &&
+               time >= filter.min_time && time <= filter.max_time;
+    });
+
+    // an empty filter shows the whole table again
+    filter_model.setFilter( ReplayFilterModel::Filter() );
+    QCOMPARE( filter_model.rowCount(), rows );
+    QCOMPARE( filter_model.mapToSource( filter_model.index(rows - 1, 0) ).row(), rows - 1 );
+}
+
+// The cells are read from the log on demand
+void ReplyTest::tableModel()
+{
+    ReplayLog replay;
+    QCOMPARE( replay.setContent( readFile("://crossdoor_trace.fbl") ), ReplayLog::SUCCESS );
+    const int rows = static_cast<int>( replay.transitionsCount() );
+
+    ReplayTableModel table_model( replay );
+    QCOMPARE( table_model.rowCount(), 0 );
+    table_model.reload();
+    QCOMPARE( table_model.rowCount(), rows );
+    QCOMPARE( table_model.columnCount(), int(ReplayTableModel::COLUMNS_COUNT) );
+
+    auto cell = [&](int row, int column)
+    {
+        return table_model.data( table_model.index(row, column) ).toString();
+    };
+
+    const double first_timestamp = replay.timestamp(0);
+    for(int row: {0, 1, rows / 2, rows - 1})
+    {
+        const auto transition = replay.transition(row);
+        QCOMPARE( cell(row, ReplayTableModel::TIME_COLUMN),
+                  QString::number( transition.timestamp - first_timestamp, 'f', 3 ) );
+        QCOMPARE( cell(row, ReplayTableModel::NAME_COLUMN),
+                  replay.tree().node( transition.index )->instance_name );
+        QCOMPARE( cell(row, ReplayTableModel::PREV_STATUS_COLUMN),
+                  QString::fromStdString( toStr( transition.prev_status ) ) );
+        QCOMPARE( cell(row, ReplayTableModel::STATUS_COLUMN),
+                  QString::fromStdString( toStr( transition.status ) ) );
+    }
+    QCOMPARE( cell(0, ReplayTableModel::TIME_COLUMN), QString("0.000") );
+    QVERIFY( !table_model.data( table_model.index(rows, 0) ).isValid() );
+
+    // as SidepanelReplay::clear()
+    replay.clear();
+    table_model.reload();
+    QCOMPARE( table_model.rowCount(), 0 );
+}
+
 QTEST_MAIN(ReplyTest)
 
 #include "replay_test.moc"